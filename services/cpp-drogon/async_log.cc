@@ -0,0 +1,378 @@
+/**
+ * Asynchronous JSON log sink.
+ */
+
+#include "async_log.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "codec.h"
+
+namespace {
+
+constexpr size_t SLOT_MASK = AsyncLogSink::SLOT_COUNT - 1;
+static_assert((AsyncLogSink::SLOT_COUNT & SLOT_MASK) == 0, "SLOT_COUNT must be a power of two");
+
+// Writes up to PIPE_BUF bytes are atomic on pipes
+constexpr size_t MAX_CHUNK = PIPE_BUF;
+
+// Writer wait when eventfd is unavailable, and between retries of a full pipe
+constexpr std::chrono::milliseconds FALLBACK_IDLE{20};
+constexpr std::chrono::milliseconds PIPE_RETRY{1};
+
+constexpr std::string_view REDACTED = "[REDACTED]";
+
+// Keys whose values are never written, matched case-insensitively
+constexpr std::array<std::string_view, 3> SECRET_KEYS = {
+    "token",
+    "x-signature-ed25519",
+    "x-signature-timestamp",
+};
+
+// trantor level tags and their Cloud Logging severities
+struct LevelTag {
+    std::string_view tag;
+    const char* severity;
+};
+constexpr std::array<LevelTag, 6> LEVEL_TAGS = {{
+    {" TRACE ", "DEBUG"},
+    {" DEBUG ", "DEBUG"},
+    {" INFO ", "INFO"},
+    {" WARN ", "WARNING"},
+    {" ERROR ", "ERROR"},
+    {" FATAL ", "CRITICAL"},
+}};
+
+// trantor puts the level after the date, time, timezone and thread id
+constexpr size_t LEVEL_SEARCH_LIMIT = 64;
+
+std::atomic<AsyncLogSink*> g_structured_sink{nullptr};
+
+bool matchesAt(const std::string& text, size_t pos, std::string_view key) {
+    if (pos + key.size() > text.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < key.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(text[pos + i])) != key[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isValueEnd(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) || c == ',' || c == ';' || c == '&' ||
+           c == '}' || c == ']' || c == '"';
+}
+
+/**
+ * Replace the value starting at pos (quoted or bare); returns the position after it
+ */
+size_t redactValue(std::string& text, size_t pos) {
+    size_t end = pos;
+    if (end < text.size() && text[end] == '"') {
+        ++pos;
+        end = pos;
+        while (end < text.size() && text[end] != '"') {
+            end += text[end] == '\\' ? 2 : 1;
+        }
+        end = std::min(end, text.size());
+    } else {
+        while (end < text.size() && !isValueEnd(text[end])) {
+            ++end;
+        }
+    }
+    if (end == pos) {
+        return pos;
+    }
+    text.replace(pos, end - pos, REDACTED);
+    return pos + REDACTED.size();
+}
+
+/**
+ * Split a trantor line into severity and message
+ */
+const char* splitLevel(std::string_view& line) {
+    std::string_view head = line.substr(0, LEVEL_SEARCH_LIMIT);
+    for (const auto& level : LEVEL_TAGS) {
+        size_t pos = head.find(level.tag);
+        if (pos != std::string_view::npos) {
+            line.remove_prefix(pos + level.tag.size());
+            while (!line.empty() && line.front() == ' ') {
+                line.remove_prefix(1);
+            }
+            return level.severity;
+        }
+    }
+    return "DEFAULT";
+}
+
+/**
+ * Render one raw line as a Cloud Logging JSON object (with trailing newline)
+ */
+void formatLine(const char* text, size_t len, std::string& scratch, std::string& out) {
+    std::string_view line(text, len);
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+        line.remove_suffix(1);
+    }
+    const char* severity = splitLevel(line);
+
+    scratch.assign(line);
+    redactSecrets(scratch);
+
+    out.clear();
+    out += R"({"severity":")";
+    out += severity;
+    out += R"(","message":")";
+    appendJsonEscaped(out, scratch);
+    out += "\"}\n";
+}
+
+/**
+ * Render a pre-built JSON object as one line, redacted like any other
+ */
+void formatObject(const char* text, size_t len, std::string& out) {
+    out.assign(text, len);
+    redactSecrets(out);
+    out += '\n';
+}
+
+}  // namespace
+
+void redactSecrets(std::string& text) {
+    for (size_t pos = 0; pos < text.size(); ++pos) {
+        if (matchesAt(text, pos, "bearer ")) {
+            pos = redactValue(text, pos + 7);
+            continue;
+        }
+        for (std::string_view key : SECRET_KEYS) {
+            if (!matchesAt(text, pos, key)) {
+                continue;
+            }
+            // Require a separator so prose such as "no access token" is left alone
+            size_t value = pos + key.size();
+            if (value < text.size() && text[value] == '"') {
+                ++value;
+            }
+            while (value < text.size() && text[value] == ' ') {
+                ++value;
+            }
+            if (value < text.size() && (text[value] == ':' || text[value] == '=')) {
+                ++value;
+                while (value < text.size() && text[value] == ' ') {
+                    ++value;
+                }
+                pos = redactValue(text, value);
+            }
+            break;
+        }
+    }
+}
+
+AsyncLogSink::AsyncLogSink(int fd)
+    : fd_(fd), slots_(new Slot[SLOT_COUNT]), wake_fd_(eventfd(0, EFD_CLOEXEC)) {
+    for (size_t i = 0; i < SLOT_COUNT; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    writer_ = std::thread([this]() { writerLoop(); });
+}
+
+AsyncLogSink::~AsyncLogSink() {
+    shutdown();
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+}
+
+void setStructuredLogSink(AsyncLogSink* sink) {
+    g_structured_sink.store(sink, std::memory_order_release);
+}
+
+void logStructured(std::string_view object) {
+    if (AsyncLogSink* sink = g_structured_sink.load(std::memory_order_acquire)) {
+        sink->pushJson(object.data(), object.size());
+        return;
+    }
+    std::string line;
+    formatObject(object.data(), object.size(), line);
+    fwrite(line.data(), 1, line.size(), stdout);
+    fflush(stdout);
+}
+
+bool AsyncLogSink::push(const char* line, size_t len) {
+    return enqueue(line, len, false);
+}
+
+bool AsyncLogSink::pushJson(const char* object, size_t len) {
+    if (len > SLOT_BYTES) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return enqueue(object, len, true);
+}
+
+bool AsyncLogSink::enqueue(const char* text, size_t len, bool json) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    for (;;) {
+        slot = &slots_[pos & SLOT_MASK];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Full: the writer has not caught up with this slot yet
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Truncate on a UTF-8 character boundary
+    if (len > SLOT_BYTES) {
+        len = SLOT_BYTES;
+        while (len > 0 && (static_cast<unsigned char>(text[len]) & 0xC0) == 0x80) {
+            --len;
+        }
+    }
+    std::memcpy(slot->text, text, len);
+    slot->len = static_cast<uint32_t>(len);
+    slot->json = json;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    // Pairs with the fence in writerLoop(): either the writer sees this
+    // slot before it sleeps, or this push sees it asleep and wakes it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_relaxed) && sleeping_.exchange(false)) {
+        wake();
+    }
+    return true;
+}
+
+bool AsyncLogSink::pending() const {
+    const Slot& slot = slots_[head_ & SLOT_MASK];
+    return slot.sequence.load(std::memory_order_acquire) == head_ + 1;
+}
+
+void AsyncLogSink::wake() {
+    if (wake_fd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void AsyncLogSink::shutdown() {
+    if (stopping_.exchange(true)) {
+        return;
+    }
+    wake();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+void AsyncLogSink::writerLoop() {
+    std::string chunk;
+    std::string line;
+    std::string scratch;
+    uint64_t reported_drops = 0;
+
+    for (;;) {
+        // Read before draining so everything pushed ahead of shutdown() is written
+        bool stopping = stopping_.load(std::memory_order_acquire);
+
+        size_t drained = 0;
+        for (;;) {
+            Slot& slot = slots_[head_ & SLOT_MASK];
+            if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) {
+                break;
+            }
+            if (slot.json) {
+                formatObject(slot.text, slot.len, line);
+            } else {
+                formatLine(slot.text, slot.len, scratch, line);
+            }
+            slot.sequence.store(head_ + SLOT_COUNT, std::memory_order_release);
+            ++head_;
+            ++drained;
+
+            if (chunk.size() + line.size() > MAX_CHUNK) {
+                writeAll(chunk);
+                chunk.clear();
+            }
+            chunk += line;
+        }
+
+        uint64_t drops = dropped_.load(std::memory_order_relaxed);
+        if (drops != reported_drops) {
+            line = R"({"severity":"WARNING","message":"log buffer full, )" +
+                   std::to_string(drops - reported_drops) + " line(s) dropped\"}\n";
+            if (chunk.size() + line.size() > MAX_CHUNK) {
+                writeAll(chunk);
+                chunk.clear();
+            }
+            chunk += line;
+            reported_drops = drops;
+        }
+        if (!chunk.empty()) {
+            writeAll(chunk);
+            chunk.clear();
+        }
+
+        // Keep draining while lines keep arriving; sleep once a pass finds none
+        if (drained > 0) {
+            continue;
+        }
+        if (stopping) {
+            return;
+        }
+        if (wake_fd_ < 0) {
+            std::this_thread::sleep_for(FALLBACK_IDLE);
+            continue;
+        }
+        sleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (pending() || stopping_.load(std::memory_order_acquire)) {
+            sleeping_.store(false, std::memory_order_relaxed);
+            continue;
+        }
+        // Blocks until a push or shutdown() writes the eventfd; a wakeup
+        // left over from an already-drained push just costs one empty pass
+        uint64_t wakeups = 0;
+        ssize_t ignored = ::read(wake_fd_, &wakeups, sizeof(wakeups));
+        (void)ignored;
+        sleeping_.store(false, std::memory_order_relaxed);
+    }
+}
+
+void AsyncLogSink::writeAll(const std::string& chunk) {
+    size_t written = 0;
+    while (written < chunk.size()) {
+        ssize_t n = ::write(fd_, chunk.data() + written, chunk.size() - written);
+        if (n > 0) {
+            written += static_cast<size_t>(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            std::this_thread::sleep_for(PIPE_RETRY);
+        } else {
+            // Output is gone; nothing sensible left to do with the line
+            return;
+        }
+    }
+}
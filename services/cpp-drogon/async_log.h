@@ -0,0 +1,103 @@
+/**
+ * Asynchronous JSON log sink.
+ *
+ * Log lines are copied into a fixed ring of slots (a bounded lock-free MPSC
+ * queue) and written by one background thread, so formatting for Cloud
+ * Logging and the write() itself never happen on an IO loop. When the ring
+ * is full, lines are dropped and counted rather than blocking the caller.
+ * An idle writer sleeps on an eventfd; only the push that finds it asleep
+ * pays for the wakeup write.
+ *
+ * The writer turns each trantor/Drogon line into a JSON object with
+ * "severity" and "message", and redacts the values of "token", the
+ * X-Signature-* headers and Bearer credentials before anything is written.
+ * Entries that carry their own fields are queued as pre-built JSON objects
+ * and written as they are, after the same redaction.
+ * Output goes out in line-aligned chunks of at most PIPE_BUF bytes, so it
+ * never interleaves mid-line with other writers on the same pipe.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+class AsyncLogSink {
+  public:
+    static constexpr size_t SLOT_COUNT = 2048;  // Power of two
+    static constexpr size_t SLOT_BYTES = 512;   // Longer lines are truncated
+
+    explicit AsyncLogSink(int fd);
+    ~AsyncLogSink();
+
+    AsyncLogSink(const AsyncLogSink&) = delete;
+    AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+    /**
+     * Queue one raw log line. Never blocks; returns false if the ring is full.
+     */
+    bool push(const char* line, size_t len);
+
+    /**
+     * Queue one JSON object to be written as its own entry. Never blocks;
+     * returns false if the ring is full or the object does not fit a slot
+     * (objects are never truncated).
+     */
+    bool pushJson(const char* object, size_t len);
+
+    /**
+     * Write everything queued so far, then stop the writer thread
+     */
+    void shutdown();
+
+    uint64_t dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        uint32_t len = 0;
+        bool json = false;  // Pre-built JSON object rather than a raw line
+        char text[SLOT_BYTES];
+    };
+
+    bool enqueue(const char* text, size_t len, bool json);
+    bool pending() const;
+    void wake();
+    void writerLoop();
+    void writeAll(const std::string& chunk);
+
+    const int fd_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) size_t head_ = 0;  // Writer thread only
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> sleeping_{false};  // Writer is blocked (or about to block) on wake_fd_
+    int wake_fd_ = -1;
+    std::thread writer_;
+};
+
+/**
+ * Redact secret values in place: "token", X-Signature-Ed25519,
+ * X-Signature-Timestamp (any case, followed by ':' or '=') and Bearer credentials
+ */
+void redactSecrets(std::string& text);
+
+/**
+ * Sink that logStructured() queues to; nullptr (the default) writes to stdout
+ */
+void setStructuredLogSink(AsyncLogSink* sink);
+
+/**
+ * Log one structured entry: a JSON object with "severity" and "message" plus
+ * whatever fields Cloud Logging should index. Secrets are redacted as for
+ * any other line.
+ */
+void logStructured(std::string_view object);
@@ -0,0 +1,119 @@
+/**
+ * Micro-benchmarks for the codec module against the original
+ * substr/stoi hex decoder and push_back base64 encoder.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdlib>
+#include <sodium.h>
+#include <string>
+#include <vector>
+
+#include "bench/fixtures.h"
+#include "codec.h"
+
+namespace {
+
+/**
+ * A real X-Signature-Ed25519 value: the contract test key's signature over
+ * a slash command (64 bytes, 128 hex characters)
+ */
+const std::string& signatureHex() {
+    static const std::string hex = []() {
+        if (sodium_init() < 0) {
+            std::abort();
+        }
+        return TestSigner().sign("1700000000", SLASH_COMMAND_BODY);
+    }();
+    return hex;
+}
+
+std::vector<unsigned char> legacyHexToBytes(const std::string& hex) {
+    std::vector<unsigned char> bytes;
+    bytes.reserve(hex.length() / 2);
+    for (size_t i = 0; i < hex.length(); i += 2) {
+        unsigned char byte = static_cast<unsigned char>(std::stoi(hex.substr(i, 2), nullptr, 16));
+        bytes.push_back(byte);
+    }
+    return bytes;
+}
+
+const char LEGACY_BASE64_CHARS[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::string legacyBase64Encode(const std::string& input) {
+    std::string output;
+    int val = 0;
+    int valb = -6;
+
+    for (unsigned char c : input) {
+        val = (val << 8) + c;
+        valb += 8;
+        while (valb >= 0) {
+            output.push_back(LEGACY_BASE64_CHARS[(val >> valb) & 0x3F]);
+            valb -= 6;
+        }
+    }
+
+    if (valb > -6) {
+        output.push_back(LEGACY_BASE64_CHARS[((val << 8) >> (valb + 8)) & 0x3F]);
+    }
+
+    while (output.size() % 4) {
+        output.push_back('=');
+    }
+
+    return output;
+}
+
+std::string payload(size_t size) {
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<char>("{\"type\":2,\"data\":{\"name\":\"test\"}}"[i % 34]);
+    }
+    return data;
+}
+
+void BM_HexToBytesLegacy(benchmark::State& state) {
+    const std::string& hex = signatureHex();
+    for (auto _ : state) {
+        auto bytes = legacyHexToBytes(hex);
+        benchmark::DoNotOptimize(bytes);
+    }
+}
+BENCHMARK(BM_HexToBytesLegacy);
+
+void BM_HexDecode(benchmark::State& state) {
+    const std::string& hex = signatureHex();
+    std::array<unsigned char, 64> bytes{};
+    for (auto _ : state) {
+        bool ok = hexDecode(hex, bytes.data(), bytes.size());
+        benchmark::DoNotOptimize(ok);
+        benchmark::DoNotOptimize(bytes);
+    }
+}
+BENCHMARK(BM_HexDecode);
+
+void BM_Base64EncodeLegacy(benchmark::State& state) {
+    std::string data = payload(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        auto encoded = legacyBase64Encode(data);
+        benchmark::DoNotOptimize(encoded);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Base64EncodeLegacy)->Range(64, 16 << 10);
+
+void BM_Base64Encode(benchmark::State& state) {
+    std::string data = payload(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        auto encoded = base64Encode(data);
+        benchmark::DoNotOptimize(encoded);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Base64Encode)->Range(64, 16 << 10);
+
+}  // namespace
@@ -0,0 +1,72 @@
+/**
+ * Shared inputs for the benchmarks and the load generator.
+ *
+ * The key pair is derived exactly like tests/contract/testkeys (Ed25519
+ * from the SHA-256 of a fixed seed string), so a server started with
+ * DISCORD_PUBLIC_KEY=TEST_PUBLIC_KEY_HEX accepts everything signed here.
+ * Payloads mirror the contract tests' Ping and slash command requests.
+ */
+
+#pragma once
+
+#include <array>
+#include <sodium.h>
+#include <string>
+#include <string_view>
+
+constexpr std::string_view TEST_SEED = "discord-bot-test-suite-ed25519-test-key-seed-v1";
+constexpr std::string_view TEST_PUBLIC_KEY_HEX =
+    "398803f0f03317b6dc57069dbe7820e5f6cf7d5ff43ad6219710b19b0b49c159";
+
+constexpr std::string_view PING_BODY =
+    R"({"type":1,"id":"test-interaction-id","application_id":"test-app-id",)"
+    R"("token":"test-token"})";
+
+constexpr std::string_view SLASH_COMMAND_BODY =
+    R"({"type":2,"id":"test-interaction-1700000000000000000","application_id":"test-app-id",)"
+    R"("token":"sensitive-token-should-be-redacted","data":{"id":"cmd-id","name":"test",)"
+    R"("options":[{"name":"message","type":3,"value":"hello from the load generator"}]},)"
+    R"("guild_id":"test-guild-id","channel_id":"test-channel-id",)"
+    R"("member":{"user":{"id":"user-id","username":"testuser"}},"locale":"en-US"})";
+
+/**
+ * The contract-test signing key
+ */
+class TestSigner {
+  public:
+    TestSigner() {
+        // Call sodium_init() before constructing
+        std::array<unsigned char, crypto_hash_sha256_BYTES> seed{};
+        crypto_hash_sha256(seed.data(), reinterpret_cast<const unsigned char*>(TEST_SEED.data()),
+                           TEST_SEED.size());
+        crypto_sign_seed_keypair(public_key_.data(), secret_key_.data(), seed.data());
+    }
+
+    /**
+     * Hex signature over timestamp + body, as sent in X-Signature-Ed25519
+     */
+    std::string sign(std::string_view timestamp, std::string_view body) const {
+        std::string message;
+        message.reserve(timestamp.size() + body.size());
+        message.append(timestamp);
+        message.append(body);
+
+        std::array<unsigned char, crypto_sign_BYTES> signature{};
+        crypto_sign_detached(signature.data(), nullptr,
+                             reinterpret_cast<const unsigned char*>(message.data()),
+                             message.size(), secret_key_.data());
+
+        static constexpr char HEX[] = "0123456789abcdef";
+        std::string hex;
+        hex.reserve(signature.size() * 2);
+        for (unsigned char byte : signature) {
+            hex += HEX[byte >> 4];
+            hex += HEX[byte & 0x0F];
+        }
+        return hex;
+    }
+
+  private:
+    std::array<unsigned char, crypto_sign_PUBLICKEYBYTES> public_key_{};
+    std::array<unsigned char, crypto_sign_SECRETKEYBYTES> secret_key_{};
+};
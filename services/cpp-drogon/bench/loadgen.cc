@@ -0,0 +1,335 @@
+/**
+ * HTTP load generator for the interaction endpoint.
+ *
+ * Replays signed Ping and slash command requests over keep-alive
+ * connections, one request in flight per connection.
+ *
+ * - closed: each connection sends its next request as soon as the last
+ *   response arrives; measures peak throughput
+ * - open: each connection follows a fixed send schedule (--rate spread
+ *   across connections). Latency is taken from when a request was due,
+ *   not when it went out, so a stalled server is charged for the requests
+ *   it held back (coordinated omission correction, as in wrk2)
+ *
+ * Usage: loadgen [--host 127.0.0.1] [--port 8080] [--path /] [--mode closed|open]
+ *                [--connections 16] [--rate 1000] [--duration 10] [--ping-ratio 0.1]
+ */
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <sodium.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bench/fixtures.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    std::string path = "/";
+    bool open_loop = false;
+    size_t connections = 16;
+    double rate = 1000;  // Requests per second across all connections (open loop)
+    double duration = 10;
+    double ping_ratio = 0.1;
+};
+
+struct WorkerStats {
+    std::vector<uint64_t> latency_ns;  // Corrected in open loop
+    std::vector<uint64_t> service_ns;  // Send to response
+    uint64_t status_2xx = 0;
+    uint64_t status_4xx = 0;
+    uint64_t status_5xx = 0;
+    uint64_t errors = 0;
+    uint64_t missed = 0;  // Open loop: due before the end but never sent
+};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string_view flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--host") {
+            options.host = value;
+        } else if (flag == "--port") {
+            options.port = std::atoi(value);
+        } else if (flag == "--path") {
+            options.path = value;
+        } else if (flag == "--mode") {
+            options.open_loop = std::string_view(value) == "open";
+        } else if (flag == "--connections") {
+            options.connections = std::max(1, std::atoi(value));
+        } else if (flag == "--rate") {
+            options.rate = std::atof(value);
+        } else if (flag == "--duration") {
+            options.duration = std::atof(value);
+        } else if (flag == "--ping-ratio") {
+            options.ping_ratio = std::atof(value);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.rate > 0 && options.duration > 0;
+}
+
+int connectTo(const Options& options) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(options.port));
+    if (inet_pton(AF_INET, options.host.c_str(), &addr.sin_addr) != 1 ||
+        connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * Read one response; returns the status code, or 0 on a broken connection.
+ * Sets keep_alive to false if the server asked to close.
+ */
+int readResponse(int fd, std::string& buffer, bool& keep_alive) {
+    size_t header_end = std::string::npos;
+    char chunk[4096];
+    while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return 0;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+
+    std::string_view headers(buffer.data(), header_end);
+    int status = headers.size() > 12 ? std::atoi(buffer.c_str() + 9) : 0;
+    size_t content_length = 0;
+    keep_alive = true;
+    for (size_t pos = headers.find("\r\n"); pos != std::string_view::npos;) {
+        size_t next = headers.find("\r\n", pos + 2);
+        std::string line(headers.substr(pos + 2, next == std::string_view::npos
+                                                      ? std::string_view::npos
+                                                      : next - pos - 2));
+        std::transform(line.begin(), line.end(), line.begin(), ::tolower);
+        if (line.rfind("content-length:", 0) == 0) {
+            content_length = std::strtoull(line.c_str() + 15, nullptr, 10);
+        } else if (line.rfind("connection:", 0) == 0 && line.find("close") != std::string::npos) {
+            keep_alive = false;
+        }
+        pos = next;
+    }
+
+    size_t total = header_end + 4 + content_length;
+    while (buffer.size() < total) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return 0;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+    buffer.erase(0, total);
+    return status;
+}
+
+/**
+ * Slash command body with a unique interaction id
+ */
+std::string commandBody(uint64_t sequence) {
+    std::string body(SLASH_COMMAND_BODY);
+    const std::string_view id = "test-interaction-1700000000000000000";
+    size_t pos = body.find(id);
+    body.replace(pos, id.size(), "loadgen-" + std::to_string(sequence));
+    return body;
+}
+
+std::string buildRequest(const Options& options, const TestSigner& signer,
+                         std::string_view body) {
+    std::string timestamp =
+        std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count());
+    std::string request = "POST " + options.path + " HTTP/1.1\r\nHost: " + options.host +
+                          "\r\nContent-Type: application/json\r\nX-Signature-Ed25519: " +
+                          signer.sign(timestamp, body) + "\r\nX-Signature-Timestamp: " +
+                          timestamp + "\r\nContent-Length: " + std::to_string(body.size()) +
+                          "\r\n\r\n";
+    request.append(body);
+    return request;
+}
+
+void runWorker(const Options& options, const TestSigner& signer, size_t index,
+               Clock::time_point start, Clock::time_point end, WorkerStats& stats) {
+    std::minstd_rand rng(static_cast<unsigned>(index) + 1);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(options.connections) / options.rate));
+    // Stagger connections across one interval
+    auto offset = interval * static_cast<Clock::rep>(index);
+    Clock::time_point due = start + offset / static_cast<Clock::rep>(options.connections);
+
+    std::string buffer;
+    int fd = -1;
+    for (uint64_t sequence = index << 40;; ++sequence) {
+        if (options.open_loop) {
+            if (due >= end) {
+                break;
+            }
+            if (Clock::now() >= end) {
+                stats.missed += static_cast<uint64_t>((end - due) / interval) + 1;
+                break;
+            }
+            std::this_thread::sleep_until(due);
+        } else if (Clock::now() >= end) {
+            break;
+        }
+
+        bool ping = coin(rng) < options.ping_ratio;
+        std::string request =
+            ping ? buildRequest(options, signer, PING_BODY)
+                 : buildRequest(options, signer, commandBody(sequence));
+
+        if (fd < 0) {
+            fd = connectTo(options);
+            buffer.clear();
+        }
+        auto sent = Clock::now();
+        bool keep_alive = false;
+        int status = fd >= 0 && sendAll(fd, request) ? readResponse(fd, buffer, keep_alive) : 0;
+        auto done = Clock::now();
+
+        if (status == 0) {
+            ++stats.errors;
+        } else {
+            auto from = options.open_loop ? due : sent;
+            stats.latency_ns.push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(done - from).count());
+            stats.service_ns.push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(done - sent).count());
+            if (status < 300) {
+                ++stats.status_2xx;
+            } else if (status < 500) {
+                ++stats.status_4xx;
+            } else {
+                ++stats.status_5xx;
+            }
+        }
+        if (status == 0 || !keep_alive) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            fd = -1;
+        }
+        due += interval;
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+void printPercentiles(const char* label, std::vector<uint64_t>& values) {
+    if (values.empty()) {
+        std::printf("%s: no responses\n", label);
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    auto at = [&values](double q) {
+        size_t rank = static_cast<size_t>(q * static_cast<double>(values.size() - 1));
+        return static_cast<double>(values[rank]) / 1e6;
+    };
+    std::printf("%s (ms): p50=%.3f p90=%.3f p99=%.3f p99.9=%.3f p99.99=%.3f max=%.3f\n", label,
+                at(0.50), at(0.90), at(0.99), at(0.999), at(0.9999),
+                static_cast<double>(values.back()) / 1e6);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: %s [--host H] [--port P] [--path /] [--mode closed|open]\n"
+                     "          [--connections N] [--rate R] [--duration S] [--ping-ratio F]\n",
+                     argv[0]);
+        return 2;
+    }
+    if (sodium_init() < 0) {
+        std::fprintf(stderr, "Failed to initialize libsodium\n");
+        return 1;
+    }
+    const TestSigner signer;
+
+    std::vector<WorkerStats> stats(options.connections);
+    std::vector<std::thread> workers;
+    auto start = Clock::now() + std::chrono::milliseconds(100);
+    auto end = start + std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::duration<double>(options.duration));
+    for (size_t i = 0; i < options.connections; ++i) {
+        workers.emplace_back([&, i]() { runWorker(options, signer, i, start, end, stats[i]); });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    WorkerStats total;
+    for (auto& s : stats) {
+        total.latency_ns.insert(total.latency_ns.end(), s.latency_ns.begin(), s.latency_ns.end());
+        total.service_ns.insert(total.service_ns.end(), s.service_ns.begin(), s.service_ns.end());
+        total.status_2xx += s.status_2xx;
+        total.status_4xx += s.status_4xx;
+        total.status_5xx += s.status_5xx;
+        total.errors += s.errors;
+        total.missed += s.missed;
+    }
+
+    size_t responses = total.latency_ns.size();
+    std::printf("mode=%s connections=%zu duration=%.1fs", options.open_loop ? "open" : "closed",
+                options.connections, elapsed);
+    if (options.open_loop) {
+        std::printf(" target_rate=%.0f/s", options.rate);
+    }
+    std::printf("\nresponses=%zu (%.0f/s) 2xx=%llu 4xx=%llu 5xx=%llu errors=%llu\n", responses,
+                static_cast<double>(responses) / elapsed,
+                static_cast<unsigned long long>(total.status_2xx),
+                static_cast<unsigned long long>(total.status_4xx),
+                static_cast<unsigned long long>(total.status_5xx),
+                static_cast<unsigned long long>(total.errors));
+    if (options.open_loop) {
+        std::printf("missed=%llu scheduled requests not sent before the end\n",
+                    static_cast<unsigned long long>(total.missed));
+        printPercentiles("latency, corrected", total.latency_ns);
+    }
+    printPercentiles("service time", total.service_ns);
+    return total.errors > 0 && responses == 0 ? 1 : 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * Micro-benchmarks for the request hot path: signature checks, body
+ * sanitization and the publish serialization path, on contract-test
+ * payloads signed with the contract-test key.
+ */
+
+#include <benchmark/benchmark.h>
+#include <json/json.h>
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench/fixtures.h"
+#include "interaction.h"
+#include "pubsub_rest.h"
+#include "signature_verifier.h"
+#include "wall_clock.h"
+
+namespace {
+
+struct SignedRequest {
+    std::string timestamp;
+    std::string signature;
+    std::string body;
+};
+
+SignatureVerifier makeVerifier(bool cache_verdicts) {
+    if (sodium_init() < 0) {
+        std::abort();
+    }
+    SignatureVerifier v;
+    std::string error;
+    if (!v.setPublicKey(std::string(TEST_PUBLIC_KEY_HEX), error)) {
+        std::abort();
+    }
+    v.setVerdictCache(cache_verdicts);
+    return v;
+}
+
+/**
+ * Full Ed25519 check on every call
+ */
+const SignatureVerifier& verifier() {
+    static const SignatureVerifier instance = makeVerifier(false);
+    return instance;
+}
+
+/**
+ * Repeats of a verified request are answered from the verdict cache
+ */
+const SignatureVerifier& cachingVerifier() {
+    static const SignatureVerifier instance = makeVerifier(true);
+    return instance;
+}
+
+/**
+ * Signed an hour ahead so the freshness check keeps passing for the whole run
+ */
+SignedRequest signedRequest(std::string_view body) {
+    verifier();
+    static const TestSigner signer;
+    SignedRequest request;
+    request.timestamp = std::to_string(wallClockSeconds() + 3600);
+    request.body = std::string(body);
+    request.signature = signer.sign(request.timestamp, request.body);
+    return request;
+}
+
+/**
+ * Arg 0 verifies every time; arg 1 repeats one request, as a retry would
+ */
+void BM_VerifyRequest(benchmark::State& state) {
+    const SignatureVerifier& v = state.range(0) == 0 ? verifier() : cachingVerifier();
+    state.SetLabel(state.range(0) == 0 ? "verify" : "cached");
+    SignedRequest request = signedRequest(SLASH_COMMAND_BODY);
+    if (!v.verifyRequest(request.signature, request.timestamp, request.body)) {
+        state.SkipWithError("signature from the test key was rejected");
+        return;
+    }
+    for (auto _ : state) {
+        bool ok = v.verifyRequest(request.signature, request.timestamp, request.body);
+        benchmark::DoNotOptimize(ok);
+    }
+}
+BENCHMARK(BM_VerifyRequest)->Arg(0)->Arg(1);
+
+void BM_VerifyRequestForged(benchmark::State& state) {
+    SignedRequest request = signedRequest(SLASH_COMMAND_BODY);
+    request.signature.replace(0, 2, request.signature[0] == '0' ? "11" : "00");
+    for (auto _ : state) {
+        bool ok = verifier().verifyRequest(request.signature, request.timestamp, request.body);
+        benchmark::DoNotOptimize(ok);
+    }
+}
+BENCHMARK(BM_VerifyRequestForged);
+
+void BM_SanitizeInteraction(benchmark::State& state) {
+    Json::Value interaction;
+    std::string errors;
+    std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+    reader->parse(SLASH_COMMAND_BODY.data(), SLASH_COMMAND_BODY.data() + SLASH_COMMAND_BODY.size(),
+                  &interaction, &errors);
+    for (auto _ : state) {
+        Json::Value sanitized = sanitizeInteraction(interaction);
+        benchmark::DoNotOptimize(sanitized);
+    }
+}
+BENCHMARK(BM_SanitizeInteraction);
+
+/**
+ * Parse and build the sanitized message; arg 0 is the backend
+ */
+void BM_BuildMessage(benchmark::State& state) {
+    auto backend = state.range(0) == 0 ? ParserBackend::Scan : ParserBackend::JsonCpp;
+    auto parser = createInteractionParser(backend);
+    state.SetLabel(state.range(0) == 0 ? "scan" : "jsoncpp");
+    for (auto _ : state) {
+        int type = 0;
+        parser->parse(SLASH_COMMAND_BODY, type);
+        PubSubMessage message = parser->buildMessage();
+        benchmark::DoNotOptimize(message);
+    }
+    state.SetBytesProcessed(state.iterations() * SLASH_COMMAND_BODY.size());
+}
+BENCHMARK(BM_BuildMessage)->Arg(0)->Arg(1);
+
+/**
+ * Everything publishToPubSub and the REST transport do to a batch of
+ * commands before the HTTP call; arg 0 is the batch size
+ */
+void BM_PublishSerialization(benchmark::State& state) {
+    auto parser = createInteractionParser(ParserBackend::Scan);
+    auto batch_size = static_cast<size_t>(state.range(0));
+    std::vector<PubSubMessage> batch;
+    batch.reserve(batch_size);
+    for (auto _ : state) {
+        batch.clear();
+        for (size_t i = 0; i < batch_size; ++i) {
+            int type = 0;
+            parser->parse(SLASH_COMMAND_BODY, type);
+            PubSubMessage message = parser->buildMessage();
+            message.attributes.emplace_back("timestamp", currentIso8601());
+            batch.push_back(std::move(message));
+        }
+        std::string body = buildPublishBody(batch);
+        benchmark::DoNotOptimize(body);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PublishSerialization)->Arg(1)->Arg(10)->Arg(100);
+
+}  // namespace
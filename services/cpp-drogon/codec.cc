@@ -0,0 +1,155 @@
+/**
+ * Binary-to-text encoding helpers.
+ */
+
+#include "codec.h"
+
+#include <array>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Base64 encoding table
+constexpr char BASE64_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Hex digit values; 0xFF marks characters that are not hex digits
+constexpr std::array<uint8_t, 256> makeHexTable() {
+    std::array<uint8_t, 256> table{};
+    for (auto& entry : table) {
+        entry = 0xFF;
+    }
+    for (int c = '0'; c <= '9'; ++c) {
+        table[c] = static_cast<uint8_t>(c - '0');
+    }
+    for (int c = 'a'; c <= 'f'; ++c) {
+        table[c] = static_cast<uint8_t>(c - 'a' + 10);
+        table[c - 'a' + 'A'] = static_cast<uint8_t>(c - 'a' + 10);
+    }
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> HEX_TABLE = makeHexTable();
+
+/**
+ * Scalar hex decode; accumulates errors instead of branching per character
+ */
+bool hexDecodeScalar(const char* hex, unsigned char* out, size_t out_size) {
+    uint8_t invalid = 0;
+    for (size_t i = 0; i < out_size; ++i) {
+        uint8_t hi = HEX_TABLE[static_cast<unsigned char>(hex[2 * i])];
+        uint8_t lo = HEX_TABLE[static_cast<unsigned char>(hex[2 * i + 1])];
+        invalid |= (hi | lo) & 0xF0;
+        out[i] = static_cast<unsigned char>((hi << 4) | (lo & 0x0F));
+    }
+    return invalid == 0;
+}
+
+#if defined(__SSE2__)
+/**
+ * Decode 16 hex characters into 8 bytes. Returns a lane mask of invalid characters.
+ */
+int hexDecodeBlock16(const char* hex, unsigned char* out) {
+    const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex));
+
+    // Digits: c - '0' in [0, 9]
+    const __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    const __m128i is_digit = _mm_cmpeq_epi8(_mm_subs_epu8(digit, _mm_set1_epi8(9)),
+                                            _mm_setzero_si128());
+
+    // Letters: (c | 0x20) - 'a' in [0, 5], value + 10
+    const __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+    const __m128i alpha = _mm_sub_epi8(lower, _mm_set1_epi8('a'));
+    const __m128i is_alpha = _mm_cmpeq_epi8(_mm_subs_epu8(alpha, _mm_set1_epi8(5)),
+                                            _mm_setzero_si128());
+
+    const __m128i values =
+        _mm_or_si128(_mm_and_si128(is_digit, digit),
+                     _mm_and_si128(is_alpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+    const int valid = _mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha));
+
+    // Each 16-bit lane holds (high nibble char, low nibble char); merge them
+    const __m128i high = _mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00FF)), 4);
+    const __m128i low = _mm_srli_epi16(values, 8);
+    const __m128i bytes = _mm_packus_epi16(_mm_or_si128(high, low), _mm_setzero_si128());
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), bytes);
+
+    return ~valid & 0xFFFF;
+}
+#endif
+
+}  // namespace
+
+void base64EncodeTo(const unsigned char* in, size_t n, char* out) {
+    size_t i = 0;
+    for (; i + 3 <= n; i += 3) {
+        uint32_t v = (uint32_t{in[i]} << 16) | (uint32_t{in[i + 1]} << 8) | in[i + 2];
+        *out++ = BASE64_CHARS[(v >> 18) & 0x3F];
+        *out++ = BASE64_CHARS[(v >> 12) & 0x3F];
+        *out++ = BASE64_CHARS[(v >> 6) & 0x3F];
+        *out++ = BASE64_CHARS[v & 0x3F];
+    }
+
+    size_t rest = n - i;
+    if (rest == 0) {
+        return;
+    }
+    uint32_t v = uint32_t{in[i]} << 16;
+    if (rest == 2) {
+        v |= uint32_t{in[i + 1]} << 8;
+    }
+    *out++ = BASE64_CHARS[(v >> 18) & 0x3F];
+    *out++ = BASE64_CHARS[(v >> 12) & 0x3F];
+    *out++ = rest == 2 ? BASE64_CHARS[(v >> 6) & 0x3F] : '=';
+    *out = '=';
+}
+
+std::string base64Encode(std::string_view input) {
+    std::string output(base64EncodedSize(input.size()), '\0');
+    base64EncodeTo(reinterpret_cast<const unsigned char*>(input.data()), input.size(),
+                   output.data());
+    return output;
+}
+
+void appendJsonEscaped(std::string& out, std::string_view text) {
+    static constexpr char HEX[] = "0123456789abcdef";
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c == '\t') {
+            out += "\\t";
+        } else if (u < 0x20) {
+            out += "\\u00";
+            out += HEX[u >> 4];
+            out += HEX[u & 0x0F];
+        } else {
+            out += c;
+        }
+    }
+}
+
+bool hexDecode(std::string_view hex, unsigned char* out, size_t out_size) {
+    if (hex.size() != out_size * 2) {
+        return false;
+    }
+
+    const char* in = hex.data();
+    size_t done = 0;
+#if defined(__SSE2__)
+    int invalid = 0;
+    for (; done + 8 <= out_size; done += 8) {
+        invalid |= hexDecodeBlock16(in + 2 * done, out + done);
+    }
+    if (invalid != 0) {
+        return false;
+    }
+#endif
+    return hexDecodeScalar(in + 2 * done, out + done, out_size - done);
+}
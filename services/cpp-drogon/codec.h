@@ -0,0 +1,44 @@
+/**
+ * Binary-to-text encoding helpers.
+ *
+ * Hex decoding is table-driven with an SSE2 path for 16-character blocks,
+ * and reports errors through its return value rather than exceptions.
+ * Base64 encoding writes into exactly-sized output with no per-character
+ * growth, so callers can encode straight into a larger buffer. JSON string
+ * escaping is shared by the log writer and the Pub/Sub REST body.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * Number of characters base64Encode produces for n input bytes (with padding)
+ */
+constexpr size_t base64EncodedSize(size_t n) {
+    return (n + 2) / 3 * 4;
+}
+
+/**
+ * Encode n bytes to Base64, writing exactly base64EncodedSize(n) characters to out
+ */
+void base64EncodeTo(const unsigned char* in, size_t n, char* out);
+
+/**
+ * Encode string to Base64
+ */
+std::string base64Encode(std::string_view input);
+
+/**
+ * Append text as JSON string contents (no quotes): escapes quotes,
+ * backslashes and control characters, passes UTF-8 through
+ */
+void appendJsonEscaped(std::string& out, std::string_view text);
+
+/**
+ * Decode hex into exactly out_size bytes.
+ * Returns false if hex is not 2 * out_size valid hex digits (either case).
+ */
+bool hexDecode(std::string_view hex, unsigned char* out, size_t out_size);
@@ -0,0 +1,83 @@
+/**
+ * CPU budget and thread placement for the IO loops.
+ */
+
+#include "cpu_affinity.h"
+
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <thread>
+
+namespace {
+
+/**
+ * CPU quota from the cgroup, rounded up; 0 when unlimited or unknown
+ */
+size_t cgroupCpuQuota() {
+    long long quota = -1;
+    long long period = 0;
+
+    // cgroup v2: "<quota> <period>" or "max <period>"
+    std::ifstream v2("/sys/fs/cgroup/cpu.max");
+    std::string quota_str;
+    if (v2 >> quota_str >> period) {
+        if (quota_str == "max") {
+            return 0;
+        }
+        try {
+            quota = std::stoll(quota_str);
+        } catch (...) {
+            return 0;
+        }
+    } else {
+        // cgroup v1: quota is -1 when unlimited
+        std::ifstream quota_file("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+        std::ifstream period_file("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+        if (!(quota_file >> quota) || !(period_file >> period)) {
+            return 0;
+        }
+    }
+
+    if (quota <= 0 || period <= 0) {
+        return 0;
+    }
+    return static_cast<size_t>((quota + period - 1) / period);
+}
+
+}  // namespace
+
+size_t availableCpus() {
+    size_t cpus = allowedCpus().size();
+    if (cpus == 0) {
+        cpus = std::thread::hardware_concurrency();
+    }
+    size_t quota = cgroupCpuQuota();
+    if (quota > 0 && (cpus == 0 || quota < cpus)) {
+        cpus = quota;
+    }
+    return cpus > 0 ? cpus : 1;
+}
+
+std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return cpus;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+bool pinCurrentThread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
@@ -0,0 +1,28 @@
+/**
+ * CPU budget and thread placement for the IO loops.
+ *
+ * Containers usually see every host core while being throttled to a CFS
+ * quota, so sizing thread pools from hardware_concurrency() oversubscribes.
+ * The budget here is the smaller of the cgroup quota (v2 cpu.max or v1
+ * cpu.cfs_quota_us, rounded up) and the scheduler affinity mask.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Number of CPUs this process may actually use (at least 1)
+ */
+size_t availableCpus();
+
+/**
+ * CPU ids in the scheduler affinity mask, in ascending order
+ */
+std::vector<int> allowedCpus();
+
+/**
+ * Pin the calling thread to one CPU. Returns false on failure.
+ */
+bool pinCurrentThread(int cpu);
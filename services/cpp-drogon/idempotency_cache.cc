@@ -0,0 +1,167 @@
+/**
+ * Bounded cache of recently published interaction ids.
+ */
+
+#include "idempotency_cache.h"
+
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+}  // namespace
+
+struct alignas(64) IdempotencyCache::Stripe {
+    struct Entry {
+        uint64_t hash = 0;
+        Clock::time_point seen;
+        bool live = false;  // False once forgotten; the slot then just ages out
+    };
+
+    std::mutex mutex;
+    std::vector<Entry> ring;      // Arrival order, oldest at `oldest`
+    std::vector<uint32_t> index;  // Ring position + 1, or 0 for an empty bucket
+    size_t oldest = 0;
+    size_t count = 0;
+
+    void init(size_t capacity) {
+        ring.resize(capacity);
+        // At most half full, so probe sequences stay short
+        index.assign(roundUpToPowerOfTwo(capacity * 2), 0);
+    }
+
+    size_t home(uint64_t hash) const {
+        return static_cast<size_t>(hash) & (index.size() - 1);
+    }
+
+    /**
+     * Bucket holding hash, or index.size() if absent
+     */
+    size_t find(uint64_t hash) const {
+        size_t mask = index.size() - 1;
+        for (size_t i = home(hash);; i = (i + 1) & mask) {
+            uint32_t slot = index[i];
+            if (slot == 0) {
+                return index.size();
+            }
+            if (ring[slot - 1].hash == hash) {
+                return i;
+            }
+        }
+    }
+
+    void insert(uint64_t hash, Clock::time_point now) {
+        size_t position = (oldest + count) % ring.size();
+        ring[position] = Entry{hash, now, true};
+        ++count;
+
+        size_t mask = index.size() - 1;
+        size_t i = home(hash);
+        while (index[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        index[i] = static_cast<uint32_t>(position + 1);
+    }
+
+    void evictOldest() {
+        if (ring[oldest].live) {
+            erase(find(ring[oldest].hash));
+        }
+        oldest = (oldest + 1) % ring.size();
+        --count;
+    }
+
+    /**
+     * Backward-shift deletion: pulls later members of the probe run into
+     * the hole so lookups never need tombstones
+     */
+    void erase(size_t hole) {
+        size_t mask = index.size() - 1;
+        index[hole] = 0;
+        for (size_t i = (hole + 1) & mask; index[i] != 0; i = (i + 1) & mask) {
+            size_t want = home(ring[index[i] - 1].hash);
+            if (((i - want) & mask) >= ((i - hole) & mask)) {
+                index[hole] = index[i];
+                index[i] = 0;
+                hole = i;
+            }
+        }
+    }
+};
+
+IdempotencyCache::IdempotencyCache(size_t capacity, std::chrono::seconds ttl)
+    : ttl_(ttl), stripes_(std::make_unique<Stripe[]>(STRIPES)) {
+    randombytes_buf(key_, sizeof(key_));
+    size_t per_stripe = (capacity + STRIPES - 1) / STRIPES;
+    for (size_t i = 0; i < STRIPES; ++i) {
+        stripes_[i].init(per_stripe > 0 ? per_stripe : 1);
+    }
+}
+
+IdempotencyCache::~IdempotencyCache() = default;
+
+uint64_t IdempotencyCache::hash(std::string_view id) const {
+    unsigned char out[crypto_shorthash_BYTES];
+    crypto_shorthash(out, reinterpret_cast<const unsigned char*>(id.data()), id.size(), key_);
+    uint64_t value = 0;
+    std::memcpy(&value, out, sizeof(value));
+    return value;
+}
+
+IdempotencyCache::Stripe& IdempotencyCache::stripeFor(uint64_t hash) const {
+    static_assert(STRIPES == 64, "stripe selection uses the top 6 hash bits");
+    // Top bits pick the stripe, low bits the bucket within it
+    return stripes_[hash >> 58];
+}
+
+bool IdempotencyCache::checkAndReserve(std::string_view id) {
+    uint64_t h = hash(id);
+    Stripe& stripe = stripeFor(h);
+
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    Clock::time_point now = Clock::now();
+    while (stripe.count > 0 && now - stripe.ring[stripe.oldest].seen >= ttl_) {
+        stripe.evictOldest();
+    }
+    if (stripe.find(h) != stripe.index.size()) {
+        return true;
+    }
+    if (stripe.count == stripe.ring.size()) {
+        stripe.evictOldest();
+    }
+    stripe.insert(h, now);
+    return false;
+}
+
+void IdempotencyCache::forget(std::string_view id) {
+    uint64_t h = hash(id);
+    Stripe& stripe = stripeFor(h);
+
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    size_t bucket = stripe.find(h);
+    if (bucket == stripe.index.size()) {
+        return;
+    }
+    stripe.ring[stripe.index[bucket] - 1].live = false;
+    stripe.erase(bucket);
+}
+
+size_t IdempotencyCache::memoryBytes() const {
+    size_t bytes = 0;
+    for (size_t i = 0; i < STRIPES; ++i) {
+        bytes += stripes_[i].ring.size() * sizeof(Stripe::Entry) +
+                 stripes_[i].index.size() * sizeof(uint32_t);
+    }
+    return bytes;
+}
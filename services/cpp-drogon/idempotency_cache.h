@@ -0,0 +1,67 @@
+/**
+ * Bounded cache of recently published interaction ids.
+ *
+ * Discord redelivers an interaction when it thinks the response timed out;
+ * the retry is validly signed, so without this it is published again. Ids
+ * are reduced to a keyed 64-bit SipHash (per-process random key, so ids
+ * cannot be chosen to collide) and spread over independently locked
+ * stripes. Each stripe owns a fixed ring of entries in arrival order and an
+ * open-addressing index into it: lookups and inserts are O(1), nothing is
+ * allocated after construction, and the oldest entry is evicted first when
+ * a stripe is full or its entries outlive the TTL.
+ *
+ * An id is reserved when its message is accepted for publishing and
+ * forgotten again if that message is then dropped, so a redelivery of a
+ * command that never reached Pub/Sub is published instead of suppressed.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sodium.h>
+#include <string_view>
+
+class IdempotencyCache {
+  public:
+    static constexpr size_t STRIPES = 64;
+
+    /**
+     * @param capacity  Ids remembered at most, across all stripes
+     * @param ttl       How long an id suppresses duplicates
+     *
+     * Call after sodium_init().
+     */
+    IdempotencyCache(size_t capacity, std::chrono::seconds ttl);
+    ~IdempotencyCache();
+
+    IdempotencyCache(const IdempotencyCache&) = delete;
+    IdempotencyCache& operator=(const IdempotencyCache&) = delete;
+
+    /**
+     * True if id was reserved within the TTL; otherwise reserves it and returns false
+     */
+    bool checkAndReserve(std::string_view id);
+
+    /**
+     * Release a reservation whose message was dropped; no-op if id is not held
+     */
+    void forget(std::string_view id);
+
+    /**
+     * Bytes held by the rings and indexes
+     */
+    size_t memoryBytes() const;
+
+  private:
+    struct Stripe;
+
+    uint64_t hash(std::string_view id) const;
+    Stripe& stripeFor(uint64_t hash) const;
+
+    std::chrono::steady_clock::duration ttl_;
+    unsigned char key_[crypto_shorthash_KEYBYTES];
+    std::unique_ptr<Stripe[]> stripes_;
+};
@@ -0,0 +1,794 @@
+/**
+ * Interaction parsing and sanitization backends.
+ */
+
+#include "interaction.h"
+
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+
+// Root-level fields copied to Pub/Sub, as listed in docs/PUBSUB-SCHEMA.md;
+// everything else (notably "token") is dropped. Edit this table to change
+// the schema: the key matcher below is derived from it at compile time.
+// Kept in byte order, the order jsoncpp writes object members in, so both
+// backends publish the fields in the same order.
+constexpr std::array<std::string_view, 10> SAFE_FIELDS = {
+    "application_id", "channel_id", "data",   "guild_id", "guild_locale",
+    "id",             "locale",     "member", "type",     "user"};
+
+static_assert(
+    []() {
+        for (size_t i = 1; i < SAFE_FIELDS.size(); ++i) {
+            if (!(SAFE_FIELDS[i - 1] < SAFE_FIELDS[i])) {
+                return false;
+            }
+        }
+        return true;
+    }(),
+    "SAFE_FIELDS must stay in byte order");
+
+// Perfect hash over SAFE_FIELDS: seeded FNV-1a into a power-of-two table,
+// with the seed searched at compile time so no two fields share a slot
+constexpr size_t SAFE_FIELD_SLOTS = 32;
+static_assert((SAFE_FIELD_SLOTS & (SAFE_FIELD_SLOTS - 1)) == 0 &&
+                  SAFE_FIELD_SLOTS >= SAFE_FIELDS.size(),
+              "slot count must be a power of two that fits every field");
+
+constexpr size_t fieldSlot(std::string_view name, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c : name) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return (hash ^ (hash >> 15)) & (SAFE_FIELD_SLOTS - 1);
+}
+
+constexpr bool isPerfectSeed(uint32_t seed) {
+    std::array<bool, SAFE_FIELD_SLOTS> used{};
+    for (std::string_view name : SAFE_FIELDS) {
+        size_t slot = fieldSlot(name, seed);
+        if (used[slot]) {
+            return false;
+        }
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t findPerfectSeed() {
+    uint32_t seed = 0;
+    while (!isPerfectSeed(seed)) {
+        ++seed;
+    }
+    return seed;
+}
+
+constexpr uint32_t SAFE_FIELD_SEED = findPerfectSeed();
+
+// Slot -> index into SAFE_FIELDS, or -1
+constexpr std::array<int8_t, SAFE_FIELD_SLOTS> SAFE_FIELD_TABLE = []() {
+    std::array<int8_t, SAFE_FIELD_SLOTS> table{};
+    for (auto& slot : table) {
+        slot = -1;
+    }
+    for (size_t i = 0; i < SAFE_FIELDS.size(); ++i) {
+        table[fieldSlot(SAFE_FIELDS[i], SAFE_FIELD_SEED)] = static_cast<int8_t>(i);
+    }
+    return table;
+}();
+
+/**
+ * Index of a plain (unescaped) key in SAFE_FIELDS, or -1 if not allowed:
+ * one hash and one comparison
+ */
+constexpr int safeFieldIndex(std::string_view name) {
+    int index = SAFE_FIELD_TABLE[fieldSlot(name, SAFE_FIELD_SEED)];
+    return index >= 0 && SAFE_FIELDS[index] == name ? index : -1;
+}
+
+static_assert(safeFieldIndex("token") == -1 && safeFieldIndex("user") == 9,
+              "allowlist matcher disagrees with SAFE_FIELDS");
+
+// Nesting limit, so hostile bodies cannot exhaust the stack
+constexpr int MAX_DEPTH = 512;
+
+bool isHexDigit(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return c - 'A' + 10;
+}
+
+void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+uint32_t readHex4(const char* p) {
+    return (hexValue(p[0]) << 12) | (hexValue(p[1]) << 8) | (hexValue(p[2]) << 4) | hexValue(p[3]);
+}
+
+/**
+ * Decode the contents of an already-validated JSON string (without quotes),
+ * appending to out
+ */
+void unescapeJsonString(std::string_view raw, std::string& out) {
+    out.reserve(out.size() + raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+        char c = raw[i];
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        char e = raw[++i];
+        switch (e) {
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'u': {
+                uint32_t cp = readHex4(raw.data() + i + 1);
+                i += 4;
+                // A high surrogate is always followed by a second \u escape
+                // (see JsonScanner::scanString); combine them as jsoncpp does.
+                // Lone low surrogates become U+FFFD.
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    uint32_t low = readHex4(raw.data() + i + 3);
+                    cp = 0x10000 + ((cp & 0x3FF) << 10) + (low & 0x3FF);
+                    i += 6;
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    cp = 0xFFFD;
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default:
+                // '"', '\\' and '/' stand for themselves
+                out += e;
+                break;
+        }
+    }
+}
+
+std::string unescapeJsonString(std::string_view raw) {
+    std::string out;
+    unescapeJsonString(raw, out);
+    return out;
+}
+
+/**
+ * Validating JSON scanner over a contiguous buffer.
+ * Checks full RFC 8259 grammar without materialising any values, plus the
+ * two checks jsoncpp adds on top: a high surrogate escape must be followed
+ * by another \u escape, and numbers must not overflow a double. Anything
+ * this accepts, jsoncpp accepts too.
+ */
+class JsonScanner {
+  public:
+    JsonScanner(const char* begin, const char* end) : pos_(begin), end_(end) {}
+
+    void skipWhitespace() {
+        while (pos_ < end_ && (*pos_ == ' ' || *pos_ == '\t' || *pos_ == '\n' || *pos_ == '\r')) {
+            ++pos_;
+        }
+    }
+
+    bool atEnd() {
+        skipWhitespace();
+        return pos_ == end_;
+    }
+
+    bool peek(char c) {
+        skipWhitespace();
+        return pos_ < end_ && *pos_ == c;
+    }
+
+    /**
+     * Scan an object, calling on_member(raw_key, value) for each member.
+     * raw_key excludes the quotes and may contain escapes.
+     */
+    template <typename OnMember>
+    bool scanObject(int depth, OnMember&& on_member) {
+        if (depth > MAX_DEPTH || !expect('{')) {
+            return false;
+        }
+        if (peek('}')) {
+            ++pos_;
+            return true;
+        }
+        for (;;) {
+            skipWhitespace();
+            const char* key_begin = pos_ + 1;
+            if (!scanString()) {
+                return false;
+            }
+            std::string_view key(key_begin, pos_ - key_begin - 1);
+            if (!expect(':')) {
+                return false;
+            }
+            skipWhitespace();
+            const char* value_begin = pos_;
+            if (!scanValue(depth)) {
+                return false;
+            }
+            on_member(key, std::string_view(value_begin, pos_ - value_begin));
+            if (peek(',')) {
+                ++pos_;
+                continue;
+            }
+            return expect('}');
+        }
+    }
+
+  private:
+    bool expect(char c) {
+        if (!peek(c)) {
+            return false;
+        }
+        ++pos_;
+        return true;
+    }
+
+    bool scanValue(int depth) {
+        skipWhitespace();
+        if (pos_ == end_) {
+            return false;
+        }
+        switch (*pos_) {
+            case '{':
+                return scanObject(depth + 1, [](std::string_view, std::string_view) {});
+            case '[':
+                return scanArray(depth + 1);
+            case '"':
+                return scanString();
+            case 't':
+                return scanLiteral("true");
+            case 'f':
+                return scanLiteral("false");
+            case 'n':
+                return scanLiteral("null");
+            default:
+                return scanNumber();
+        }
+    }
+
+    bool scanArray(int depth) {
+        if (depth > MAX_DEPTH || !expect('[')) {
+            return false;
+        }
+        if (peek(']')) {
+            ++pos_;
+            return true;
+        }
+        for (;;) {
+            if (!scanValue(depth)) {
+                return false;
+            }
+            if (peek(',')) {
+                ++pos_;
+                continue;
+            }
+            return expect(']');
+        }
+    }
+
+    bool scanString() {
+        if (pos_ == end_ || *pos_ != '"') {
+            return false;
+        }
+        ++pos_;
+        while (pos_ < end_) {
+            auto c = static_cast<unsigned char>(*pos_);
+            if (c == '"') {
+                ++pos_;
+                return true;
+            }
+            if (c < 0x20) {
+                return false;
+            }
+            if (c == '\\') {
+                if (++pos_ == end_) {
+                    return false;
+                }
+                switch (*pos_) {
+                    case '"':
+                    case '\\':
+                    case '/':
+                    case 'b':
+                    case 'f':
+                    case 'n':
+                    case 'r':
+                    case 't':
+                        break;
+                    case 'u': {
+                        if (!scanHex4(pos_ + 1)) {
+                            return false;
+                        }
+                        uint32_t cp = readHex4(pos_ + 1);
+                        pos_ += 4;
+                        // jsoncpp wants a second escape after a high surrogate
+                        if (cp >= 0xD800 && cp <= 0xDBFF &&
+                            (end_ - pos_ < 7 || pos_[1] != '\\' || pos_[2] != 'u')) {
+                            return false;
+                        }
+                        break;
+                    }
+                    default:
+                        return false;
+                }
+            }
+            ++pos_;
+        }
+        return false;
+    }
+
+    bool scanHex4(const char* p) const {
+        return end_ - p >= 4 && isHexDigit(p[0]) && isHexDigit(p[1]) && isHexDigit(p[2]) &&
+               isHexDigit(p[3]);
+    }
+
+    bool scanDigits() {
+        const char* start = pos_;
+        while (pos_ < end_ && *pos_ >= '0' && *pos_ <= '9') {
+            ++pos_;
+        }
+        return pos_ > start;
+    }
+
+    bool scanNumber() {
+        const char* start = pos_;
+        if (pos_ < end_ && *pos_ == '-') {
+            ++pos_;
+        }
+        if (pos_ < end_ && *pos_ == '0') {
+            ++pos_;
+        } else if (!scanDigits()) {
+            return false;
+        }
+        // Only an exponent or a very long integer part can reach DBL_MAX
+        bool may_overflow = pos_ - start > std::numeric_limits<double>::max_exponent10;
+        if (pos_ < end_ && *pos_ == '.') {
+            ++pos_;
+            if (!scanDigits()) {
+                return false;
+            }
+        }
+        if (pos_ < end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+            may_overflow = true;
+            ++pos_;
+            if (pos_ < end_ && (*pos_ == '+' || *pos_ == '-')) {
+                ++pos_;
+            }
+            if (!scanDigits()) {
+                return false;
+            }
+        }
+        return !may_overflow ||
+               std::isfinite(std::strtod(std::string(start, pos_).c_str(), nullptr));
+    }
+
+    bool scanLiteral(std::string_view literal) {
+        if (static_cast<size_t>(end_ - pos_) < literal.size() ||
+            std::string_view(pos_, literal.size()) != literal) {
+            return false;
+        }
+        pos_ += literal.size();
+        return true;
+    }
+
+    const char* pos_;
+    const char* end_;
+};
+
+/**
+ * Compare a raw (possibly escaped) JSON key with a plain name
+ */
+bool keyEquals(std::string_view raw_key, std::string_view name) {
+    if (raw_key.find('\\') == std::string_view::npos) {
+        return raw_key == name;
+    }
+    return unescapeJsonString(raw_key) == name;
+}
+
+/**
+ * Check whether a raw JSON value is a number
+ */
+bool isNumber(std::string_view raw) {
+    return !raw.empty() &&
+           (raw.front() == '-' || std::isdigit(static_cast<unsigned char>(raw.front())));
+}
+
+/**
+ * Parse a JSON number as an int the way Json::Value::isInt() would accept it
+ */
+bool numberAsInt(std::string_view text, int& out) {
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    if (ec == std::errc() && ptr == text.data() + text.size()) {
+        return true;
+    }
+    if (ec == std::errc::result_out_of_range) {
+        return false;
+    }
+    // Fraction or exponent: integral values in range still count (e.g. 2.0)
+    double value = std::strtod(std::string(text).c_str(), nullptr);
+    if (std::trunc(value) != value || value < std::numeric_limits<int>::min() ||
+        value > std::numeric_limits<int>::max()) {
+        return false;
+    }
+    out = static_cast<int>(value);
+    return true;
+}
+
+/**
+ * Spell a JSON number the way Json::Value::asString() does: integers that
+ * fit 64 bits in plain decimal, anything else through jsoncpp's double
+ * formatting
+ */
+void numberAsString(std::string_view text, std::string& out) {
+    const char* end = text.data() + text.size();
+    if (text.front() == '-') {
+        int64_t value = 0;
+        auto [ptr, ec] = std::from_chars(text.data(), end, value);
+        if (ec == std::errc() && ptr == end) {
+            out = std::to_string(value);
+            return;
+        }
+    } else {
+        uint64_t value = 0;
+        auto [ptr, ec] = std::from_chars(text.data(), end, value);
+        if (ec == std::errc() && ptr == end) {
+            out = std::to_string(value);
+            return;
+        }
+    }
+    out = Json::Value(std::strtod(std::string(text).c_str(), nullptr)).asString();
+}
+
+/**
+ * Render a raw JSON value as a Pub/Sub attribute string, as the jsoncpp
+ * backend would. Returns false for objects and arrays, which have no
+ * attribute form.
+ */
+bool attributeValue(std::string_view raw, std::string& out) {
+    if (raw.empty() || raw.front() == '{' || raw.front() == '[') {
+        return false;
+    }
+    out.clear();
+    if (raw.front() == '"') {
+        unescapeJsonString(raw.substr(1, raw.size() - 2), out);
+    } else if (isNumber(raw)) {
+        numberAsString(raw, out);
+    } else if (raw != "null") {
+        out.assign(raw);
+    }
+    return true;
+}
+
+/**
+ * DOM-free backend: validates in one pass and records the byte range of
+ * each allowlisted root-level field
+ */
+class ScanInteractionParser : public InteractionParser {
+  public:
+    /**
+     * @param fallback  Hand bodies the scanner rejects to jsoncpp, so the
+     *                  backend accepts exactly what jsoncpp accepts
+     */
+    explicit ScanInteractionParser(bool fallback = false) : use_fallback_(fallback) {}
+
+    ParseStatus parse(std::string_view body, int& type) override {
+        in_fallback_ = false;
+        ParseStatus status = scan(body, type);
+        if (status == ParseStatus::InvalidJson && use_fallback_) {
+            // Comments, trailing content, lenient numbers: jsoncpp decides.
+            // Only signed bodies get here, and Discord sends strict JSON.
+            in_fallback_ = true;
+            return fallback().parse(body, type);
+        }
+        return status;
+    }
+
+    PubSubMessage buildMessage() override {
+        if (in_fallback_) {
+            return fallback_->buildMessage();
+        }
+
+        // Sanitized payload: allowlisted fields only, values copied verbatim
+        size_t size = 2;
+        for (size_t i = 0; i < SAFE_FIELDS.size(); ++i) {
+            if (!fields_[i].empty()) {
+                size += SAFE_FIELDS[i].size() + fields_[i].size() + 4;
+            }
+        }
+        PubSubMessage message(size);
+        auto& data = message.data;
+        data.reserve(size);
+        data += '{';
+        for (size_t i = 0; i < SAFE_FIELDS.size(); ++i) {
+            if (fields_[i].empty()) {
+                continue;
+            }
+            if (data.size() > 1) {
+                data += ',';
+            }
+            data += '"';
+            data += SAFE_FIELDS[i];
+            data += "\":";
+            data += fields_[i];
+        }
+        data += '}';
+
+        // Add attributes; value_ is reused so conversions do not allocate per request
+        auto& attributes = message.attributes;
+        std::string& value = value_;
+        if (attributeValue(fields_[ID], value)) {
+            attributes.emplace_back("interaction_id", value);
+        }
+        attributes.emplace_back("interaction_type", std::to_string(type_));
+        if (attributeValue(fields_[APPLICATION_ID], value)) {
+            attributes.emplace_back("application_id", value);
+        }
+        if (attributeValue(fields_[GUILD_ID], value)) {
+            attributes.emplace_back("guild_id", value);
+        }
+        if (attributeValue(fields_[CHANNEL_ID], value)) {
+            attributes.emplace_back("channel_id", value);
+        }
+        std::string_view command_name = findMember(fields_[DATA], "name");
+        if (attributeValue(command_name, value)) {
+            attributes.emplace_back("command_name", value);
+        }
+
+        return message;
+    }
+
+  private:
+    // Indexes into SAFE_FIELDS
+    static constexpr size_t TYPE = safeFieldIndex("type");
+    static constexpr size_t ID = safeFieldIndex("id");
+    static constexpr size_t APPLICATION_ID = safeFieldIndex("application_id");
+    static constexpr size_t DATA = safeFieldIndex("data");
+    static constexpr size_t GUILD_ID = safeFieldIndex("guild_id");
+    static constexpr size_t CHANNEL_ID = safeFieldIndex("channel_id");
+
+    /**
+     * Strict single-pass parse; the body must be RFC 8259 JSON
+     */
+    ParseStatus scan(std::string_view body, int& type) {
+        fields_.fill(std::string_view());
+
+        // Skip a UTF-8 byte order mark, as jsoncpp does
+        if (body.size() >= 3 && body.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+            body.remove_prefix(3);
+        }
+
+        JsonScanner scanner(body.data(), body.data() + body.size());
+        if (!scanner.peek('{')) {
+            return ParseStatus::InvalidJson;
+        }
+        bool ok = scanner.scanObject(1, [this](std::string_view key, std::string_view value) {
+            int index = key.find('\\') == std::string_view::npos
+                            ? safeFieldIndex(key)
+                            : safeFieldIndex(unescapeJsonString(key));
+            if (index >= 0) {
+                // Duplicate keys: last one wins, matching jsoncpp
+                fields_[index] = value;
+            }
+        });
+        if (!ok || !scanner.atEnd()) {
+            return ParseStatus::InvalidJson;
+        }
+
+        std::string_view type_text = fields_[TYPE];
+        if (!isNumber(type_text) || !numberAsInt(type_text, type_)) {
+            return ParseStatus::UnsupportedType;
+        }
+        type = type_;
+        return ParseStatus::Ok;
+    }
+
+    /**
+     * Find a member's raw value inside an already-validated object
+     */
+    static std::string_view findMember(std::string_view object, std::string_view name) {
+        std::string_view found;
+        if (object.empty() || object.front() != '{') {
+            return found;
+        }
+        JsonScanner scanner(object.data(), object.data() + object.size());
+        scanner.scanObject(1, [&](std::string_view key, std::string_view value) {
+            if (keyEquals(key, name)) {
+                found = value;
+            }
+        });
+        return found;
+    }
+
+    /**
+     * The jsoncpp backend, created on first use
+     */
+    InteractionParser& fallback();
+
+    std::array<std::string_view, SAFE_FIELDS.size()> fields_;
+    int type_ = 0;
+    std::string value_;
+    const bool use_fallback_;
+    bool in_fallback_ = false;
+    std::unique_ptr<InteractionParser> fallback_;
+};
+
+/**
+ * Reference backend: full jsoncpp DOM
+ */
+class JsonCppInteractionParser : public InteractionParser {
+  public:
+    JsonCppInteractionParser() : reader_(Json::CharReaderBuilder().newCharReader()) {}
+
+    ParseStatus parse(std::string_view body, int& type) override {
+        // Fast path: a valid Ping needs no tree at all
+        if (ping_probe_.parse(body, type) == ParseStatus::Ok && type == INTERACTION_TYPE_PING) {
+            return ParseStatus::Ok;
+        }
+
+        interaction_ = Json::Value();
+        std::string errors;
+        if (!reader_->parse(body.data(), body.data() + body.size(), &interaction_, &errors)) {
+            return ParseStatus::InvalidJson;
+        }
+
+        // Ensure interaction is an object (not null, array, or primitive)
+        if (!interaction_.isObject()) {
+            return ParseStatus::InvalidJson;
+        }
+
+        if (!interaction_.isMember("type") || !interaction_["type"].isInt()) {
+            return ParseStatus::UnsupportedType;
+        }
+        type = interaction_["type"].asInt();
+        return ParseStatus::Ok;
+    }
+
+    PubSubMessage buildMessage() override {
+        // The parsed tree is not needed again, so its subtrees are moved out
+        Json::Value sanitized = sanitizeInteraction(std::move(interaction_));
+
+        // Convert to JSON string; the transport encodes it for the wire
+        Json::StreamWriterBuilder writer;
+        writer["indentation"] = "";
+
+        std::string serialized = Json::writeString(writer, sanitized);
+        PubSubMessage message(serialized.size());
+        message.data = serialized;
+
+        // Add attributes (objects and arrays have no attribute form)
+        auto& attributes = message.attributes;
+        auto addAttribute = [&attributes](const char* name, const Json::Value& object,
+                                          const char* key) {
+            if (object.isMember(key) && object[key].isConvertibleTo(Json::stringValue)) {
+                attributes.emplace_back(name, object[key].asString());
+            }
+        };
+        const Json::Value& fields = sanitized;
+        addAttribute("interaction_id", fields, "id");
+        attributes.emplace_back("interaction_type", std::to_string(fields["type"].asInt()));
+        addAttribute("application_id", fields, "application_id");
+        addAttribute("guild_id", fields, "guild_id");
+        addAttribute("channel_id", fields, "channel_id");
+        if (fields["data"].isObject()) {
+            addAttribute("command_name", fields["data"], "name");
+        }
+
+        return message;
+    }
+
+  private:
+    ScanInteractionParser ping_probe_;
+    std::unique_ptr<Json::CharReader> reader_;
+    Json::Value interaction_;
+};
+
+InteractionParser& ScanInteractionParser::fallback() {
+    if (!fallback_) {
+        fallback_ = std::make_unique<JsonCppInteractionParser>();
+    }
+    return *fallback_;
+}
+
+}  // namespace
+
+bool parseParserBackend(const std::string& name, ParserBackend& backend) {
+    if (name == "scan") {
+        backend = ParserBackend::Scan;
+    } else if (name == "jsoncpp") {
+        backend = ParserBackend::JsonCpp;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<InteractionParser> createInteractionParser(ParserBackend backend) {
+    switch (backend) {
+        case ParserBackend::JsonCpp:
+            return std::make_unique<JsonCppInteractionParser>();
+        case ParserBackend::Scan:
+            break;
+    }
+    return std::make_unique<ScanInteractionParser>(true);
+}
+
+bool isPingInteraction(std::string_view body) {
+    thread_local ScanInteractionParser probe;
+    int type = 0;
+    return probe.parse(body, type) == ParseStatus::Ok && type == INTERACTION_TYPE_PING;
+}
+
+Json::Value sanitizeInteraction(const Json::Value& interaction) {
+    Json::Value sanitized;
+    if (!interaction.isObject()) {
+        return sanitized;
+    }
+    // One pass over the input's keys; "token" and anything unlisted is skipped
+    for (auto it = interaction.begin(); it != interaction.end(); ++it) {
+        const char* end = nullptr;
+        const char* begin = it.memberName(&end);
+        int index = safeFieldIndex(std::string_view(begin, static_cast<size_t>(end - begin)));
+        if (index >= 0) {
+            sanitized[Json::StaticString(SAFE_FIELDS[index].data())] = *it;
+        }
+    }
+    return sanitized;
+}
+
+Json::Value sanitizeInteraction(Json::Value&& interaction) {
+    Json::Value sanitized;
+    if (!interaction.isObject()) {
+        return sanitized;
+    }
+    for (auto it = interaction.begin(); it != interaction.end(); ++it) {
+        const char* end = nullptr;
+        const char* begin = it.memberName(&end);
+        int index = safeFieldIndex(std::string_view(begin, static_cast<size_t>(end - begin)));
+        if (index >= 0) {
+            sanitized[Json::StaticString(SAFE_FIELDS[index].data())] = std::move(*it);
+        }
+    }
+    return sanitized;
+}
@@ -0,0 +1,87 @@
+/**
+ * Interaction parsing and sanitization backends.
+ *
+ * A parser validates the request body, reports the interaction type and,
+ * for slash commands, produces the sanitized Pub/Sub message. Two backends
+ * are available:
+ * - scan: validating single-pass scanner that never builds a DOM; the
+ *   sanitized payload is assembled from byte ranges of the allowlisted
+ *   root-level fields, so "token" is dropped without re-serializing
+ * - jsoncpp: full Json::Value tree, kept as the reference implementation;
+ *   Pings are recognised by the scanner first and never reach the DOM
+ *
+ * Both accept and reject the same bodies: the scanner is strict RFC 8259,
+ * and whatever it rejects (comments, trailing content, leading zeros and
+ * the other leniencies of jsoncpp's reader) is handed to the jsoncpp
+ * backend. Both publish the root-level fields in the same (byte) order.
+ * Nested values differ only in spelling: scan copies them as sent, jsoncpp
+ * re-serializes them with sorted keys and \u escapes for non-ASCII text.
+ */
+
+#pragma once
+
+#include <json/json.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "pubsub_transport.h"
+
+// Interaction types
+constexpr int INTERACTION_TYPE_PING = 1;
+constexpr int INTERACTION_TYPE_APPLICATION_COMMAND = 2;
+
+enum class ParserBackend {
+    Scan,
+    JsonCpp,
+};
+
+enum class ParseStatus {
+    Ok,               // Body is a JSON object with an integer "type"
+    InvalidJson,      // Malformed JSON or not an object
+    UnsupportedType,  // "type" missing or not an integer
+};
+
+/**
+ * Parse a backend name ("scan" or "jsoncpp"). Returns false if unknown.
+ */
+bool parseParserBackend(const std::string& name, ParserBackend& backend);
+
+class InteractionParser {
+  public:
+    virtual ~InteractionParser() = default;
+
+    /**
+     * Parse the request body and report the interaction type.
+     * The body must stay alive until buildMessage() has been called.
+     */
+    virtual ParseStatus parse(std::string_view body, int& type) = 0;
+
+    /**
+     * Build the sanitized Pub/Sub message for the last successful parse.
+     * Sets data and the interaction attributes; the caller adds "timestamp".
+     */
+    virtual PubSubMessage buildMessage() = 0;
+};
+
+/**
+ * Create a parser; instances are stateful and must not be shared across threads
+ */
+std::unique_ptr<InteractionParser> createInteractionParser(ParserBackend backend);
+
+/**
+ * Cheap check that a body is a well-formed Ping; no signature check and no
+ * allocation, so it can run ahead of verification when shedding load
+ */
+bool isPingInteraction(std::string_view body);
+
+/**
+ * Sanitize interaction for Pub/Sub (remove sensitive fields)
+ */
+Json::Value sanitizeInteraction(const Json::Value& interaction);
+
+/**
+ * Same, moving the allowed subtrees out of interaction instead of copying them
+ */
+Json::Value sanitizeInteraction(Json::Value&& interaction);
@@ -9,273 +9,753 @@
  */
 
 #include <drogon/drogon.h>
+#include <trantor/utils/Logger.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
 #include <chrono>
+#include <condition_variable>
+#include <cstdio>
 #include <cstdlib>
-#include <iomanip>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sodium.h>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <unistd.h>
 #include <vector>
 
-using namespace drogon;
-
-// Base64 encoding table
-static const char base64_chars[] =
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-
-/**
- * Encode string to Base64
- */
-std::string base64Encode(const std::string& input) {
-    std::string output;
-    int val = 0;
-    int valb = -6;
+#include "async_log.h"
+#include "cpu_affinity.h"
+#include "idempotency_cache.h"
+#include "interaction.h"
+#include "metrics.h"
+#include "publish_batcher.h"
+#include "publish_executor.h"
+#include "publish_outbox.h"
+#include "pubsub_rest.h"
+#include "pubsub_transport.h"
+#include "signature_verifier.h"
+#include "startup_timing.h"
+#include "topic_router.h"
+#include "wall_clock.h"
 
-    for (unsigned char c : input) {
-        val = (val << 8) + c;
-        valb += 8;
-        while (valb >= 0) {
-            output.push_back(base64_chars[(val >> valb) & 0x3F]);
-            valb -= 6;
-        }
-    }
+#ifdef ENABLE_PROFILING
+#include "profiler.h"
+#endif
+#ifdef ENABLE_PUBSUB_GRPC
+#include "pubsub_grpc.h"
+#endif
 
-    if (valb > -6) {
-        output.push_back(base64_chars[((val << 8) >> (valb + 8)) & 0x3F]);
-    }
+using namespace drogon;
 
-    while (output.size() % 4) {
-        output.push_back('=');
-    }
+// Largest accepted request body; Discord interactions are a few KB
+constexpr size_t MAX_BODY_SIZE = 1024 * 1024;
 
-    return output;
-}
+// Windowed /debug/pprof profiles: ?seconds= default, and the cap longer
+// requests are clamped to
+constexpr long DEFAULT_PPROF_SECONDS = 30;
+constexpr long MAX_PPROF_SECONDS = 120;
 
-// Interaction types
-constexpr int INTERACTION_TYPE_PING = 1;
-constexpr int INTERACTION_TYPE_APPLICATION_COMMAND = 2;
+// Shortest accepted PPROF_TOKEN
+constexpr size_t MIN_PPROF_TOKEN_LENGTH = 16;
 
 // Response types
 constexpr int RESPONSE_TYPE_PONG = 1;
 constexpr int RESPONSE_TYPE_DEFERRED_CHANNEL_MESSAGE = 5;
 
+// Responses served on the hot path; bodies are serialized once at startup
+enum class Canned {
+    Pong,
+    Deferred,
+    InvalidSignature,
+    InvalidJson,
+    UnsupportedType,
+    Overloaded,
+};
+constexpr size_t CANNED_COUNT = 6;
+
+struct CannedBody {
+    HttpStatusCode status = k200OK;
+    std::string body;
+};
+std::array<CannedBody, CANNED_COUNT> g_canned_bodies;
+
 // Global configuration
-std::vector<unsigned char> g_public_key;
+SignatureVerifier g_verifier;
 std::string g_pubsub_topic;
 std::string g_project_id;
 std::string g_pubsub_emulator_host;
+std::string g_pubsub_endpoint = "pubsub.googleapis.com";
+
+// Publish worker pool defaults (overridable via environment)
+constexpr size_t DEFAULT_PUBSUB_WORKERS = 4;
+constexpr size_t DEFAULT_PUBSUB_QUEUE_DEPTH = 1024;
+constexpr OverflowPolicy DEFAULT_PUBSUB_OVERFLOW = OverflowPolicy::DropNew;
+constexpr size_t DEFAULT_PUBSUB_CLIENT_LOOPS = 1;
+
+// Async publishing (PUBSUB_ASYNC): workers only dispatch, and responses are
+// handled on the client loops, so connections no longer track workers
+constexpr size_t DEFAULT_PUBSUB_MAX_IN_FLIGHT = 256;
+constexpr size_t DEFAULT_PUBSUB_ASYNC_CONNECTIONS = 16;
+
+// Time allowed after SIGTERM to flush queued publishes and the outbox; Cloud
+// Run sends SIGKILL 10 s after SIGTERM
+constexpr std::chrono::milliseconds DEFAULT_PUBSUB_DRAIN{8000};
+
+// How long past the drain deadline threads whose calls were cut short get to
+// return before they are left behind
+constexpr std::chrono::milliseconds DRAIN_JOIN_GRACE{250};
+
+// Retry outbox for transient publish failures (PUBSUB_OUTBOX_PATH empty keeps it in memory)
+constexpr const char* DEFAULT_PUBSUB_OUTBOX_PATH = "/tmp/pubsub-outbox.seg";
+constexpr size_t DEFAULT_PUBSUB_OUTBOX_BYTES = 16 * 1024 * 1024;
+
+// gRPC calls over an open HTTP/2 channel are cheap, so favour latency
+constexpr std::chrono::milliseconds DEFAULT_GRPC_BATCH_DELAY{1};
+constexpr size_t DEFAULT_PUBSUB_DEDUP_ENTRIES = 65536;
+constexpr size_t DEFAULT_PUBSUB_DEDUP_TTL_SECONDS = 300;
+
+// One topic's publish pipeline, sized from the service-wide settings with
+// NAME_<TOPIC> overrides
+struct RouteSettings {
+    std::string topic;
+    size_t workers = DEFAULT_PUBSUB_WORKERS;
+    size_t queue_depth = DEFAULT_PUBSUB_QUEUE_DEPTH;
+    size_t connections = DEFAULT_PUBSUB_WORKERS;
+    size_t max_in_flight = DEFAULT_PUBSUB_MAX_IN_FLIGHT;
+    BatchConfig batch;
+    std::string outbox_path;
+    size_t outbox_bytes = DEFAULT_PUBSUB_OUTBOX_BYTES;
+};
+
+// Pub/Sub settings resolved from the environment at boot
+struct PubSubSettings {
+    std::string transport = "rest";
+    size_t workers = DEFAULT_PUBSUB_WORKERS;
+    size_t queue_depth = DEFAULT_PUBSUB_QUEUE_DEPTH;
+    OverflowPolicy overflow = DEFAULT_PUBSUB_OVERFLOW;
+    size_t connections = DEFAULT_PUBSUB_WORKERS;
+    bool async = true;
+    size_t max_in_flight = DEFAULT_PUBSUB_MAX_IN_FLIGHT;
+    BatchConfig batch;
+    OverloadConfig overload;
+    bool outbox = true;
+    std::string outbox_path = DEFAULT_PUBSUB_OUTBOX_PATH;
+    size_t outbox_bytes = DEFAULT_PUBSUB_OUTBOX_BYTES;
+    std::chrono::milliseconds drain = DEFAULT_PUBSUB_DRAIN;
+    std::vector<RouteSettings> routes;  // Indexed like g_topic_router.topics()
+};
+bool g_pubsub_enabled = false;
+PubSubSettings g_pubsub_settings;
+
+// Command name to route index (PUBSUB_ROUTES); route 0 is PUBSUB_TOPIC
+TopicRouter g_topic_router;
+
+// Everything that publishes to one topic (only created when Pub/Sub is
+// configured). Routes share no queue, worker or connection.
+struct PublishRoute {
+    const RouteSettings* settings = nullptr;
+    std::unique_ptr<PubSubTransport> transport;  // REST or gRPC
+    std::unique_ptr<PublishOutbox> outbox;       // Retries (PUBSUB_OUTBOX, on by default)
+    std::unique_ptr<InFlightLimit> in_flight;    // Awaiting a response (async mode only)
+    std::unique_ptr<PublishExecutor> executor;   // Background publish workers
+    std::unique_ptr<PublishBatcher> batcher;     // Feeds the workers
+};
+// Interaction ids already published (PUBSUB_DEDUP, on by default). Declared
+// ahead of the routes: batches destroyed with them still forget their ids.
+std::unique_ptr<IdempotencyCache> g_idempotency_cache;
+
+std::vector<std::unique_ptr<PublishRoute>> g_publish_routes;
+
+// Lazy start (PUBSUB_INIT=lazy): the publisher stack is built on a startup
+// thread once the listener is up or the first slash command arrives.
+// Messages published before then wait in g_pubsub_pending; g_publish_routes
+// is complete once g_pubsub_ready is set.
+std::atomic<bool> g_pubsub_ready{false};
+std::atomic<bool> g_pubsub_start_requested{false};
+std::mutex g_pubsub_start_mutex;
+std::condition_variable g_pubsub_start_cv;
+bool g_pubsub_start_cancelled = false;
+bool g_pubsub_start_finished = false;  // The startup thread has returned or is about to
+std::vector<PubSubMessage> g_pubsub_pending;
+std::thread g_pubsub_start_thread;
+
+// Background log writer (LOG_ASYNC, on by default) and success-log sampling
+// (LOG_SUCCESS_SAMPLE=N logs one in N successful publishes per worker)
+std::unique_ptr<AsyncLogSink> g_log_sink;
+size_t g_log_success_sample = 1;
+
+// Request body parser (INTERACTION_PARSER=scan|jsoncpp)
+ParserBackend g_parser_backend = ParserBackend::Scan;
+
+#ifdef ENABLE_PROFILING
+// BLAKE2b of PPROF_TOKEN; the /debug/pprof routes exist only when it is set
+std::array<unsigned char, crypto_generichash_BYTES> g_pprof_token_hash;
+#endif
 
 /**
- * Convert hex string to bytes
+ * Read a positive integer from the environment, falling back to a default
  */
-std::vector<unsigned char> hexToBytes(const std::string& hex) {
-    std::vector<unsigned char> bytes;
-    bytes.reserve(hex.length() / 2);
-    for (size_t i = 0; i < hex.length(); i += 2) {
-        unsigned char byte = static_cast<unsigned char>(std::stoi(hex.substr(i, 2), nullptr, 16));
-        bytes.push_back(byte);
+size_t getEnvSize(const char* name, size_t default_value) {
+    const char* value = std::getenv(name);
+    if (!value || *value == '\0') {
+        return default_value;
     }
-    return bytes;
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(value, &end, 10);
+    if (*end != '\0' || parsed == 0) {
+        LOG_WARN << "Ignoring invalid " << name << "=" << value;
+        return default_value;
+    }
+    return static_cast<size_t>(parsed);
 }
 
 /**
- * Validate Discord Ed25519 signature
+ * Read a boolean flag from the environment (1/true/yes/on or 0/false/no/off)
  */
-bool validateSignature(const std::string& signature_hex, const std::string& timestamp,
-                       const std::string& body) {
-    if (signature_hex.empty() || timestamp.empty() || g_public_key.empty()) {
+bool getEnvBool(const char* name, bool default_value) {
+    const char* value = std::getenv(name);
+    if (!value || *value == '\0') {
+        return default_value;
+    }
+    std::string flag = value;
+    if (flag == "1" || flag == "true" || flag == "yes" || flag == "on") {
+        return true;
+    }
+    if (flag == "0" || flag == "false" || flag == "no" || flag == "off") {
         return false;
     }
+    LOG_WARN << "Ignoring invalid " << name << "=" << value;
+    return default_value;
+}
 
-    // Check timestamp (must be within 5 seconds)
-    try {
-        int64_t ts = std::stoll(timestamp);
-        auto now = std::chrono::system_clock::now();
-        auto epoch = now.time_since_epoch();
-        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(epoch).count();
-        if (seconds - ts > 5) {
-            return false;
-        }
-    } catch (...) {
-        return false;
+/**
+ * Read a per-topic setting: NAME_<TOPIC> overrides NAME, which overrides the default.
+ * The topic is upper-cased with non-alphanumeric characters mapped to '_'.
+ */
+size_t getTopicEnvSize(const std::string& name, const std::string& topic, size_t default_value) {
+    std::string topic_name = name + "_";
+    for (char c : topic) {
+        topic_name += std::isalnum(static_cast<unsigned char>(c))
+                          ? static_cast<char>(std::toupper(static_cast<unsigned char>(c)))
+                          : '_';
     }
+    return getEnvSize(topic_name.c_str(), getEnvSize(name.c_str(), default_value));
+}
 
-    // Decode signature
-    std::vector<unsigned char> signature;
-    try {
-        signature = hexToBytes(signature_hex);
-    } catch (...) {
-        return false;
+/**
+ * Size one route's pipeline: the service-wide settings, overridden per topic.
+ * Routes other than the first keep their retries in "<outbox path>.<topic>".
+ */
+RouteSettings resolveRouteSettings(const PubSubSettings& settings, const std::string& topic,
+                                   bool primary) {
+    RouteSettings route;
+    route.topic = topic;
+    route.workers = getTopicEnvSize("PUBSUB_WORKERS", topic, settings.workers);
+    route.queue_depth = getTopicEnvSize("PUBSUB_QUEUE_DEPTH", topic, settings.queue_depth);
+    route.connections = getTopicEnvSize("PUBSUB_CONNECTIONS", topic, settings.connections);
+    route.max_in_flight = getTopicEnvSize("PUBSUB_MAX_IN_FLIGHT", topic, settings.max_in_flight);
+
+    BatchConfig& batch = route.batch;
+    batch = settings.batch;
+    batch.max_messages = getTopicEnvSize("PUBSUB_BATCH_MAX_MESSAGES", topic, batch.max_messages);
+    batch.max_bytes = getTopicEnvSize("PUBSUB_BATCH_MAX_BYTES", topic, batch.max_bytes);
+    batch.max_delay = std::chrono::milliseconds(
+        getTopicEnvSize("PUBSUB_BATCH_MAX_DELAY_MS", topic, batch.max_delay.count()));
+
+    route.outbox_path = settings.outbox_path;
+    if (!primary && !route.outbox_path.empty()) {
+        route.outbox_path += "." + topic;
     }
+    route.outbox_bytes = getTopicEnvSize("PUBSUB_OUTBOX_BYTES", topic, settings.outbox_bytes);
+    return route;
+}
 
-    if (signature.size() != crypto_sign_BYTES) {
-        return false;
+/**
+ * Pin each IO loop to its own CPU from the affinity mask (wrapping if there
+ * are more loops than CPUs). Call once the loops are running.
+ */
+void pinIoLoops() {
+    std::vector<int> cpus = allowedCpus();
+    if (cpus.empty()) {
+        return;
+    }
+    for (size_t i = 0; i < app().getThreadNum(); ++i) {
+        int cpu = cpus[i % cpus.size()];
+        app().getIOLoop(i)->queueInLoop([i, cpu]() {
+            if (!pinCurrentThread(cpu)) {
+                LOG_WARN << "Failed to pin IO loop " << i << " to CPU " << cpu;
+            }
+        });
     }
+}
 
-    // Verify signature: verify(timestamp + body)
-    std::string message = timestamp + body;
+/**
+ * Validate Discord Ed25519 signature
+ */
+bool validateSignature(const std::string& signature_hex, const std::string& timestamp,
+                       std::string_view body) {
+    return g_verifier.verifyRequest(signature_hex, timestamp, body);
+}
 
-    int result = crypto_sign_verify_detached(signature.data(),
-                                             reinterpret_cast<const unsigned char*>(message.data()),
-                                             message.size(), g_public_key.data());
+/**
+ * Serialize pre-built response bodies (call once at startup)
+ */
+void initCannedResponses() {
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+    auto set = [&writer](Canned which, HttpStatusCode status, const Json::Value& json) {
+        g_canned_bodies[static_cast<size_t>(which)] = {status, Json::writeString(writer, json)};
+    };
+    auto error = [](const char* message) {
+        Json::Value json;
+        json["error"] = message;
+        return json;
+    };
+
+    Json::Value pong;
+    pong["type"] = RESPONSE_TYPE_PONG;
+    set(Canned::Pong, k200OK, pong);
 
-    return result == 0;
+    Json::Value deferred;
+    deferred["type"] = RESPONSE_TYPE_DEFERRED_CHANNEL_MESSAGE;
+    set(Canned::Deferred, k200OK, deferred);
+
+    set(Canned::InvalidSignature, k401Unauthorized, error("invalid signature"));
+    set(Canned::InvalidJson, k400BadRequest, error("invalid JSON"));
+    set(Canned::UnsupportedType, k400BadRequest, error("unsupported interaction type"));
+    set(Canned::Overloaded, k503ServiceUnavailable, error("overloaded"));
 }
 
 /**
- * Create JSON error response
+ * Get a pre-rendered, immutable response.
+ * Drogon responses must not be shared across IO threads, so each loop keeps
+ * its own copy (the same approach Drogon uses for its 404 page).
  */
-HttpResponsePtr errorResponse(int status, const std::string& error) {
-    Json::Value json;
-    json["error"] = error;
-    auto resp = HttpResponse::newHttpJsonResponse(json);
-    resp->setStatusCode(static_cast<HttpStatusCode>(status));
+const HttpResponsePtr& cannedResponse(Canned which) {
+    thread_local std::array<HttpResponsePtr, CANNED_COUNT> responses;
+    auto& resp = responses[static_cast<size_t>(which)];
+    if (!resp) {
+        const auto& canned = g_canned_bodies[static_cast<size_t>(which)];
+        resp = HttpResponse::newHttpResponse();
+        resp->setStatusCode(canned.status);
+        resp->setContentTypeCode(CT_APPLICATION_JSON);
+        resp->setBody(canned.body);
+        // Never expires: Drogon renders it once and reuses the buffer
+        resp->setExpiredTime(0);
+    }
     return resp;
 }
 
 /**
- * Sanitize interaction for Pub/Sub (remove sensitive fields)
+ * Add the publish timestamp attribute to a message
  */
-Json::Value sanitizeInteraction(const Json::Value& interaction) {
-    Json::Value sanitized;
+void addTimestampAttribute(PubSubMessage& message) {
+    message.attributes.emplace_back("timestamp", currentIso8601());
+}
 
-    // Copy safe fields only (explicitly exclude "token")
-    if (interaction.isMember("type"))
-        sanitized["type"] = interaction["type"];
-    if (interaction.isMember("id"))
-        sanitized["id"] = interaction["id"];
-    if (interaction.isMember("application_id"))
-        sanitized["application_id"] = interaction["application_id"];
-    if (interaction.isMember("data"))
-        sanitized["data"] = interaction["data"];
-    if (interaction.isMember("guild_id"))
-        sanitized["guild_id"] = interaction["guild_id"];
-    if (interaction.isMember("channel_id"))
-        sanitized["channel_id"] = interaction["channel_id"];
-    if (interaction.isMember("member"))
-        sanitized["member"] = interaction["member"];
-    if (interaction.isMember("user"))
-        sanitized["user"] = interaction["user"];
-    if (interaction.isMember("locale"))
-        sanitized["locale"] = interaction["locale"];
-    if (interaction.isMember("guild_locale"))
-        sanitized["guild_locale"] = interaction["guild_locale"];
+/**
+ * Value of a message attribute, or empty if it is not set
+ */
+std::string_view attributeValue(const PubSubMessage& message, std::string_view name) {
+    for (const auto& [key, value] : message.attributes) {
+        if (key == name) {
+            return value;
+        }
+    }
+    return {};
+}
 
-    return sanitized;
+/**
+ * Release the dedup reservation of a message that will not be published, so
+ * Discord's redelivery of it goes out instead of counting as a duplicate
+ */
+void forgetInteraction(const PubSubMessage& message) {
+    std::string_view id = attributeValue(message, "interaction_id");
+    if (g_idempotency_cache && !id.empty()) {
+        g_idempotency_cache->forget(id);
+    }
+}
+
+/**
+ * Same for messages[from..]
+ */
+void forgetInteractions(const std::vector<PubSubMessage>& messages, size_t from = 0) {
+    for (size_t i = from; i < messages.size(); ++i) {
+        forgetInteraction(messages[i]);
+    }
 }
 
+// Message accounting for the shutdown summary
+std::atomic<uint64_t> g_messages_published{0};
+std::atomic<uint64_t> g_messages_dropped{0};
+std::atomic<uint64_t> g_messages_unsettled{0};  // Submitted, outcome not yet handled
+
+/**
+ * A batch on its way through the executor and transport. If it is
+ * destroyed before settle() (rejected, evicted, or discarded at the drain
+ * deadline), it logs the drop and its messages count as dropped.
+ */
+class PendingBatch {
+  public:
+    PendingBatch(const std::string& topic, PublishBatcher::Batch&& messages)
+        : topic_(topic), messages_(std::move(messages)) {
+        g_messages_unsettled += messages_.size();
+    }
+
+    // The one place a shed batch is seen, whichever policy shed it
+    ~PendingBatch() {
+        if (!settled_) {
+            LOG_WARN << "Pub/Sub batch of " << messages_.size() << " message(s) for " << topic_
+                     << " dropped before publishing (queue full or shutting down)";
+            forgetInteractions(messages_);
+            g_messages_dropped += messages_.size();
+            g_messages_unsettled -= messages_.size();
+        }
+    }
+
+    PendingBatch(const PendingBatch&) = delete;
+    PendingBatch& operator=(const PendingBatch&) = delete;
+
+    const PublishBatcher::Batch& messages() const {
+        return messages_;
+    }
+
+    void settle() {
+        settled_ = true;
+        g_messages_unsettled -= messages_.size();
+    }
+
+  private:
+    const std::string& topic_;
+    PublishBatcher::Batch messages_;
+    bool settled_ = false;
+};
+
 /**
- * Publish interaction to Pub/Sub emulator via REST API
+ * Record, log and (if transient) queue for retry the outcome of one publish
  */
-void publishToPubSub(const Json::Value& interaction) {
-    if (g_pubsub_topic.empty() || g_project_id.empty() || g_pubsub_emulator_host.empty()) {
+void finishPubSubBatch(PublishRoute& route, PendingBatch& pending, const PublishOutcome& outcome,
+                       std::chrono::steady_clock::time_point started) {
+    const PublishBatcher::Batch& batch = pending.messages();
+    pending.settle();
+    recordLatency(LatencyMetric::Publish, std::chrono::steady_clock::now() - started);
+    recordPublish(batch.size(), outcome.ok, outcome.code, route.transport->name());
+
+    if (outcome.ok) {
+        g_messages_published += batch.size();
+        thread_local size_t successes = 0;
+        if (++successes % g_log_success_sample == 0) {
+            LOG_INFO << "Published " << batch.size() << " message(s) to Pub/Sub successfully"
+                     << (g_log_success_sample > 1 ? " (sampled)" : "");
+        }
         return;
     }
 
-    Json::Value sanitized = sanitizeInteraction(interaction);
+    const std::string& topic = route.settings->topic;
+    if (outcome.code != 0) {
+        LOG_ERROR << "Pub/Sub publish to " << topic << " failed: " << route.transport->name()
+                  << " status " << outcome.code << " - " << outcome.error;
+    } else {
+        LOG_ERROR << "Pub/Sub publish to " << topic << " failed: " << outcome.error;
+    }
 
-    // Convert to JSON string and base64 encode
-    Json::StreamWriterBuilder writer;
-    writer["indentation"] = "";
-    std::string jsonStr = Json::writeString(writer, sanitized);
-    std::string base64Data = base64Encode(jsonStr);
+    if (!outcome.retryable || !route.outbox) {
+        forgetInteractions(batch);
+        g_messages_dropped += batch.size();
+        return;
+    }
+    // The outbox counts whatever does not fit
+    size_t stored = route.outbox->append(batch);
+    forgetInteractions(batch, stored);
+    if (stored == batch.size()) {
+        LOG_WARN << "Queued " << batch.size() << " message(s) in the Pub/Sub outbox for retry";
+    } else {
+        LOG_ERROR << "Pub/Sub outbox full, batch of " << batch.size()
+                  << " message(s) not fully queued";
+    }
+}
 
-    // Build Pub/Sub REST API request body
-    Json::Value pubsubMsg;
-    pubsubMsg["messages"][0]["data"] = base64Data;
+/**
+ * Send a batch of messages in a single publish call
+ */
+void sendPubSubBatch(PublishRoute& route, std::shared_ptr<PendingBatch> batch) {
+    auto started = std::chrono::steady_clock::now();
+    if (!route.in_flight) {
+        finishPubSubBatch(route, *batch, route.transport->publish(batch->messages()), started);
+        return;
+    }
+
+    // Async: the worker is free again once the request is handed over, and
+    // the outcome is handled on the transport's loop. Past the drain
+    // deadline no slot is handed out and the batch counts as dropped.
+    if (!route.in_flight->acquire()) {
+        return;
+    }
+    route.transport->publishAsync(
+        batch->messages(), [&route, batch, started](PublishOutcome outcome) {
+            finishPubSubBatch(route, *batch, outcome, started);
+            route.in_flight->release();
+        });
+}
 
-    // Add attributes
-    if (sanitized.isMember("id")) {
-        pubsubMsg["messages"][0]["attributes"]["interaction_id"] = sanitized["id"].asString();
+/**
+ * Open a route's retry outbox, falling back to memory if the file is unusable
+ */
+std::unique_ptr<PublishOutbox> openPublishOutbox(PublishRoute& route) {
+    const RouteSettings& settings = *route.settings;
+    auto outbox = std::make_unique<PublishOutbox>(
+        settings.batch.max_messages, [&route](const PublishOutbox::Batch& batch) {
+            PublishOutcome outcome = route.transport->publish(batch);
+            recordPublish(batch.size(), outcome.ok, outcome.code, route.transport->name());
+            if (outcome.ok) {
+                g_messages_published += batch.size();
+            } else if (!outcome.retryable) {
+                forgetInteractions(batch);
+            }
+            return outcome;
+        });
+
+    std::string error;
+    if (outbox->open(settings.outbox_path, settings.outbox_bytes, error)) {
+        if (size_t replayed = outbox->pending()) {
+            LOG_INFO << "Pub/Sub outbox replaying " << replayed << " message(s) from "
+                     << settings.outbox_path;
+        }
+        return outbox;
     }
-    if (sanitized.isMember("type")) {
-        pubsubMsg["messages"][0]["attributes"]["interaction_type"] =
-            std::to_string(sanitized["type"].asInt());
+    LOG_WARN << "Pub/Sub outbox " << settings.outbox_path << " unavailable (" << error
+             << "), keeping retries in memory";
+    if (!settings.outbox_path.empty() && outbox->open("", settings.outbox_bytes, error)) {
+        return outbox;
     }
-    if (sanitized.isMember("application_id")) {
-        pubsubMsg["messages"][0]["attributes"]["application_id"] =
-            sanitized["application_id"].asString();
+    LOG_ERROR << "Pub/Sub outbox disabled: " << error;
+    return nullptr;
+}
+
+/**
+ * Create the configured Pub/Sub transport for one topic.
+ * Uses the emulator when PUBSUB_EMULATOR_HOST is set, otherwise production
+ * Pub/Sub (PUBSUB_ENDPOINT) with the given metadata-server access tokens.
+ */
+std::unique_ptr<PubSubTransport> createPubSubTransport(
+    const std::string& transport, const std::string& topic, size_t connections,
+    const std::shared_ptr<MetadataTokenProvider>& tokens) {
+    const std::string topic_path = "projects/" + g_project_id + "/topics/" + topic;
+    const bool emulator = !g_pubsub_emulator_host.empty();
+
+    if (transport == "grpc") {
+#ifdef ENABLE_PUBSUB_GRPC
+        std::string endpoint = emulator ? g_pubsub_emulator_host : g_pubsub_endpoint + ":443";
+        return std::make_unique<GrpcPubSubTransport>(endpoint, topic_path, tokens);
+#else
+        LOG_ERROR << "PUBSUB_TRANSPORT=grpc requires a build with -DPUBSUB_GRPC=ON";
+        return nullptr;
+#endif
     }
-    if (sanitized.isMember("guild_id")) {
-        pubsubMsg["messages"][0]["attributes"]["guild_id"] = sanitized["guild_id"].asString();
+
+    size_t client_loops = getEnvSize("PUBSUB_CLIENT_LOOPS", DEFAULT_PUBSUB_CLIENT_LOOPS);
+    size_t pipelining = getEnvSize("PUBSUB_PIPELINING", 0);
+    std::string base_url =
+        emulator ? "http://" + g_pubsub_emulator_host : "https://" + g_pubsub_endpoint;
+    auto clients =
+        std::make_unique<PubSubClientPool>(base_url, connections, client_loops, pipelining);
+    return std::make_unique<RestPubSubTransport>(std::move(clients), topic_path, tokens);
+}
+
+/**
+ * Route for a message, from its command_name attribute
+ */
+PublishRoute& routeFor(const PubSubMessage& message) {
+    return *g_publish_routes[g_topic_router.route(attributeValue(message, "command_name"))];
+}
+
+/**
+ * Build a transport, workers and batcher per route, then hand over any
+ * messages queued while starting. Returns false if a transport could not be
+ * created.
+ */
+bool startPubSub() {
+    auto started = std::chrono::steady_clock::now();
+    const PubSubSettings& settings = g_pubsub_settings;
+
+    // One token source serves every route
+    std::shared_ptr<MetadataTokenProvider> tokens;
+    if (g_pubsub_emulator_host.empty()) {
+        tokens = std::make_shared<MetadataTokenProvider>();
     }
-    if (sanitized.isMember("channel_id")) {
-        pubsubMsg["messages"][0]["attributes"]["channel_id"] = sanitized["channel_id"].asString();
+
+    std::vector<std::unique_ptr<PublishRoute>> routes;
+    for (const RouteSettings& route_settings : settings.routes) {
+        auto route = std::make_unique<PublishRoute>();
+        route->settings = &route_settings;
+        route->transport = createPubSubTransport(settings.transport, route_settings.topic,
+                                                 route_settings.connections, tokens);
+        if (!route->transport) {
+            return false;
+        }
+        routes.push_back(std::move(route));
     }
-    if (sanitized.isMember("data") && sanitized["data"].isMember("name")) {
-        pubsubMsg["messages"][0]["attributes"]["command_name"] =
-            sanitized["data"]["name"].asString();
+
+    for (auto& route_ptr : routes) {
+        PublishRoute& route = *route_ptr;
+        const RouteSettings& route_settings = *route.settings;
+        route.transport->warmUp();
+        if (settings.outbox) {
+            route.outbox = openPublishOutbox(route);
+        }
+        if (settings.async) {
+            route.in_flight = std::make_unique<InFlightLimit>(route_settings.max_in_flight);
+        }
+        route.executor = std::make_unique<PublishExecutor>(
+            route_settings.workers, route_settings.queue_depth, settings.overflow,
+            settings.overload);
+        route.batcher = std::make_unique<PublishBatcher>(
+            route_settings.batch, [&route](PublishBatcher::Batch&& messages) {
+                // Messages are move-only; std::function needs a copyable task.
+                // Under DropOldest a rejection sheds an older batch, not this
+                // one, so the shed batch logs itself when it is destroyed.
+                auto batch =
+                    std::make_shared<PendingBatch>(route.settings->topic, std::move(messages));
+                route.executor->submit([&route, batch]() { sendPubSubBatch(route, batch); });
+            });
     }
 
-    // Get current timestamp
-    auto now = std::chrono::system_clock::now();
-    auto time_t_now = std::chrono::system_clock::to_time_t(now);
-    std::stringstream ss;
-    ss << std::put_time(std::gmtime(&time_t_now), "%Y-%m-%dT%H:%M:%SZ");
-    pubsubMsg["messages"][0]["attributes"]["timestamp"] = ss.str();
+    size_t queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_pubsub_start_mutex);
+        g_publish_routes = std::move(routes);
+        queued = g_pubsub_pending.size();
+        for (auto& message : g_pubsub_pending) {
+            routeFor(message).batcher->add(std::move(message));
+        }
+        g_pubsub_pending.clear();
+        g_pubsub_pending.shrink_to_fit();
+        g_pubsub_ready.store(true, std::memory_order_release);
+    }
 
-    std::string requestBody = Json::writeString(writer, pubsubMsg);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started);
+    LOG_INFO << "Pub/Sub ready in " << elapsed.count() << " ms (" << g_publish_routes.size()
+             << " route(s), " << queued << " queued message(s))";
+    return true;
+}
 
-    // Build URL: http://{emulator}/v1/projects/{project}/topics/{topic}:publish
-    std::string url = "http://" + g_pubsub_emulator_host + "/v1/projects/" + g_project_id +
-                      "/topics/" + g_pubsub_topic + ":publish";
+/**
+ * Ask the startup thread to build the publisher stack (no-op once asked)
+ */
+void requestPubSubStart() {
+    if (g_pubsub_start_requested.load(std::memory_order_relaxed)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_pubsub_start_mutex);
+        g_pubsub_start_requested = true;
+    }
+    g_pubsub_start_cv.notify_all();
+}
 
-    // Parse host and port from emulator host
-    std::string host = g_pubsub_emulator_host;
-    uint16_t port = 8085;
-    size_t colonPos = host.find(':');
-    if (colonPos != std::string::npos) {
-        port = static_cast<uint16_t>(std::stoi(host.substr(colonPos + 1)));
-        host = host.substr(0, colonPos);
+/**
+ * True if this interaction id is already being published; Discord
+ * redelivers interactions it thinks timed out, and retries are validly
+ * signed. Otherwise reserves the id until the message is published or
+ * dropped (see forgetInteraction).
+ */
+bool isDuplicate(const PubSubMessage& message) {
+    if (!g_idempotency_cache) {
+        return false;
     }
+    std::string_view id = attributeValue(message, "interaction_id");
+    return !id.empty() && g_idempotency_cache->checkAndReserve(id);
+}
 
-    // Create HTTP client and send request
-    auto client = HttpClient::newHttpClient("http://" + g_pubsub_emulator_host);
+/**
+ * Queue interaction for publishing to Pub/Sub. Returns false, without
+ * queueing, if the command's route is overloaded.
+ */
+bool publishToPubSub(InteractionParser& parser) {
+    if (!g_pubsub_enabled) {
+        return true;
+    }
+    PubSubMessage message = parser.buildMessage();
+    PublishRoute* route = nullptr;
+    if (g_pubsub_ready.load(std::memory_order_acquire)) {
+        // Refuse before the id is remembered, so Discord's retry is not a duplicate
+        route = &routeFor(message);
+        if (route->executor->overloaded()) {
+            return false;
+        }
+    }
+    if (isDuplicate(message)) {
+        recordDuplicate();
+        return true;
+    }
+    addTimestampAttribute(message);
 
-    auto req = HttpRequest::newHttpRequest();
-    req->setMethod(Post);
-    req->setPath("/v1/projects/" + g_project_id + "/topics/" + g_pubsub_topic + ":publish");
-    req->setContentTypeCode(CT_APPLICATION_JSON);
-    req->setBody(requestBody);
+    if (route) {
+        route->batcher->add(std::move(message));
+        return true;
+    }
 
-    // Send synchronously (we're already in a background thread)
-    auto [result, resp] = client->sendRequest(req, 5.0);
+    // Still starting: hold the message rather than wait for the publisher stack
+    requestPubSubStart();
+    std::unique_lock<std::mutex> lock(g_pubsub_start_mutex);
+    if (g_pubsub_ready.load(std::memory_order_acquire)) {
+        lock.unlock();
+        routeFor(message).batcher->add(std::move(message));
+        return true;
+    }
+    if (g_pubsub_pending.size() >= g_pubsub_settings.queue_depth) {
+        lock.unlock();
+        forgetInteraction(message);
+        LOG_WARN << "Pub/Sub still starting, message dropped";
+        return true;
+    }
+    g_pubsub_pending.push_back(std::move(message));
+    return true;
+}
 
-    if (result == ReqResult::Ok && resp) {
-        if (resp->getStatusCode() == k200OK) {
-            LOG_INFO << "Published to Pub/Sub successfully";
-        } else {
-            LOG_ERROR << "Pub/Sub publish failed: HTTP " << resp->getStatusCode() << " - "
-                      << resp->body();
+/**
+ * True while every route is behind, so any new command would be refused;
+ * commands for a single overloaded route are refused once parsed
+ */
+bool publishOverloaded() {
+    if (!g_pubsub_ready.load(std::memory_order_acquire)) {
+        return false;
+    }
+    for (const auto& route : g_publish_routes) {
+        if (!route->executor->overloaded()) {
+            return false;
         }
-    } else {
-        LOG_ERROR << "Pub/Sub publish failed: connection error";
     }
+    return true;
 }
 
 /**
  * Handle Ping interaction
  */
-HttpResponsePtr handlePing() {
-    Json::Value response;
-    response["type"] = RESPONSE_TYPE_PONG;
-    return HttpResponse::newHttpJsonResponse(response);
+const HttpResponsePtr& handlePing() {
+    return cannedResponse(Canned::Pong);
 }
 
 /**
  * Handle Application Command (slash command)
  */
-HttpResponsePtr handleApplicationCommand(const Json::Value& interaction) {
-    // Publish to Pub/Sub in background
-    std::thread([interaction]() { publishToPubSub(interaction); }).detach();
+const HttpResponsePtr& handleApplicationCommand(InteractionParser& parser) {
+    // Hand off to the batcher; the HTTP call happens on the publish workers
+    if (!publishToPubSub(parser)) {
+        recordShed();
+        return cannedResponse(Canned::Overloaded);
+    }
 
     // Respond with deferred response (non-ephemeral)
-    Json::Value response;
-    response["type"] = RESPONSE_TYPE_DEFERRED_CHANNEL_MESSAGE;
-    return HttpResponse::newHttpJsonResponse(response);
+    return cannedResponse(Canned::Deferred);
 }
 
 /**
@@ -283,41 +763,52 @@ HttpResponsePtr handleApplicationCommand(const Json::Value& interaction) {
  */
 void handleInteraction(const HttpRequestPtr& req,
                        std::function<void(const HttpResponsePtr&)>&& callback) {
-    // Get signature headers
-    std::string signature = req->getHeader("X-Signature-Ed25519");
-    std::string timestamp = req->getHeader("X-Signature-Timestamp");
-    std::string body = std::string(req->body());
-
-    // Validate signature
-    if (!validateSignature(signature, timestamp, body)) {
-        callback(errorResponse(401, "invalid signature"));
-        return;
-    }
+    ScopedLatency handler_timer(LatencyMetric::Handler);
 
-    // Parse JSON
-    Json::Value interaction;
-    Json::CharReaderBuilder builder;
-    std::string errors;
-    std::istringstream stream(body);
+    // Get signature headers; the body is viewed in place in Drogon's buffer
+    const std::string& signature = req->getHeader("X-Signature-Ed25519");
+    const std::string& timestamp = req->getHeader("X-Signature-Timestamp");
+    std::string_view body = req->body();
 
-    if (!Json::parseFromStream(builder, stream, &interaction, &errors)) {
-        callback(errorResponse(400, "invalid JSON"));
+    // Shed load before paying for verification; Pings are always answered
+    // so Discord keeps the endpoint marked healthy
+    if (publishOverloaded() && !isPingInteraction(body)) {
+        recordShed();
+        callback(cannedResponse(Canned::Overloaded));
         return;
     }
 
-    // Ensure interaction is an object (not null, array, or primitive)
-    if (!interaction.isObject()) {
-        callback(errorResponse(400, "invalid JSON"));
-        return;
+    // Validate signature
+    bool valid = false;
+    {
+        ScopedLatency timer(LatencyMetric::SignatureVerify);
+        valid = validateSignature(signature, timestamp, body);
     }
-
-    // Get interaction type
-    if (!interaction.isMember("type") || !interaction["type"].isInt()) {
-        callback(errorResponse(400, "unsupported interaction type"));
+    if (!valid) {
+        callback(cannedResponse(Canned::InvalidSignature));
         return;
     }
 
-    int interactionType = interaction["type"].asInt();
+    // Parse JSON directly from the request buffer
+    thread_local std::unique_ptr<InteractionParser> parser =
+        createInteractionParser(g_parser_backend);
+    int interactionType = 0;
+
+    ParseStatus status = ParseStatus::InvalidJson;
+    {
+        ScopedLatency timer(LatencyMetric::Parse);
+        status = parser->parse(body, interactionType);
+    }
+    switch (status) {
+        case ParseStatus::Ok:
+            break;
+        case ParseStatus::InvalidJson:
+            callback(cannedResponse(Canned::InvalidJson));
+            return;
+        case ParseStatus::UnsupportedType:
+            callback(cannedResponse(Canned::UnsupportedType));
+            return;
+    }
 
     // Handle by type
     switch (interactionType) {
@@ -325,14 +816,128 @@ void handleInteraction(const HttpRequestPtr& req,
             callback(handlePing());
             break;
         case INTERACTION_TYPE_APPLICATION_COMMAND:
-            callback(handleApplicationCommand(interaction));
+            callback(handleApplicationCommand(*parser));
             break;
         default:
-            callback(errorResponse(400, "unsupported interaction type"));
+            callback(cannedResponse(Canned::UnsupportedType));
             break;
     }
 }
 
+/**
+ * Exit path: flush the batcher, finish queued and in-flight publishes and
+ * retry the outbox, all within the PUBSUB_DRAIN_MS deadline, then log how
+ * many messages made it out and stop the client loops. Returns false if a
+ * thread was still busy at the deadline and had to be left running; the
+ * routes must then not be destroyed.
+ */
+bool drainPubSub() {
+    using Clock = std::chrono::steady_clock;
+    auto started = Clock::now();
+    auto deadline = started + g_pubsub_settings.drain;
+    auto join_deadline = deadline + DRAIN_JOIN_GRACE;
+    uint64_t published_before = g_messages_published.load();
+    uint64_t dropped_before = g_messages_dropped.load();
+
+    // Let a lazy start finish (or skip it if never requested)
+    if (g_pubsub_start_thread.joinable()) {
+        bool finished = false;
+        size_t waiting = 0;
+        {
+            std::unique_lock<std::mutex> lock(g_pubsub_start_mutex);
+            g_pubsub_start_cancelled = true;
+            g_pubsub_start_cv.notify_all();
+            finished = g_pubsub_start_cv.wait_until(lock, join_deadline,
+                                                    []() { return g_pubsub_start_finished; });
+            waiting = g_pubsub_pending.size();
+        }
+        if (!finished) {
+            g_pubsub_start_thread.detach();
+            LOG_WARN << "Pub/Sub drain: still starting at the deadline, " << waiting
+                     << " queued message(s) not sent";
+            return false;
+        }
+        g_pubsub_start_thread.join();
+    }
+    uint64_t never_sent = 0;
+    if (!g_pubsub_ready.load(std::memory_order_acquire)) {
+        // The publisher never came up; messages held for it are lost
+        std::lock_guard<std::mutex> lock(g_pubsub_start_mutex);
+        never_sent = g_pubsub_pending.size();
+    }
+    std::vector<uint64_t> outbox_dropped_before;
+    for (const auto& route : g_publish_routes) {
+        outbox_dropped_before.push_back(route->outbox ? route->outbox->dropped() : 0);
+        // No publish, token fetch or in-flight wait may run past the deadline
+        route->transport->setDeadline(deadline);
+        if (route->in_flight) {
+            route->in_flight->setDeadline(deadline);
+        }
+    }
+
+    // Each stage is finished on every route before the next; the routes'
+    // workers and retries keep running side by side meanwhile. A thread
+    // that ignores its deadline is left behind, not waited for.
+    bool stopped = true;
+    for (const auto& route : g_publish_routes) {
+        route->batcher->shutdown();
+    }
+    for (const auto& route : g_publish_routes) {
+        if (!route->executor->shutdown(join_deadline)) {
+            LOG_WARN << "Pub/Sub drain: " << route->settings->topic
+                     << " worker still publishing at the deadline, not waiting for it";
+            stopped = false;
+        }
+    }
+    for (const auto& route : g_publish_routes) {
+        if (route->in_flight) {
+            auto left = std::max(Clock::duration::zero(), deadline - Clock::now());
+            route->in_flight->waitIdle(std::chrono::duration_cast<std::chrono::milliseconds>(left));
+        }
+    }
+    // Outbox records survive only in a file the next instance opens
+    uint64_t kept = 0;
+    uint64_t lost = 0;
+    uint64_t outbox_dropped = 0;
+    for (size_t i = 0; i < g_publish_routes.size(); ++i) {
+        PublishOutbox* outbox = g_publish_routes[i]->outbox.get();
+        if (!outbox) {
+            continue;
+        }
+        size_t left = outbox->drain(deadline);
+        if (g_publish_routes[i]->settings->outbox_path.empty()) {
+            lost += left;
+        } else {
+            kept += left;
+        }
+        outbox_dropped += outbox->dropped() - outbox_dropped_before[i];
+        if (!outbox->shutdown(join_deadline)) {
+            LOG_WARN << "Pub/Sub drain: " << g_publish_routes[i]->settings->topic
+                     << " outbox retry still running at the deadline, not waiting for it";
+            stopped = false;
+        }
+    }
+
+    // Whatever is still awaiting a response is abandoned
+    uint64_t dropped = g_messages_dropped.load() - dropped_before + g_messages_unsettled.load() +
+                       outbox_dropped + never_sent + lost;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - started);
+    LOG_INFO << "Pub/Sub drain took " << elapsed.count() << " ms: "
+             << g_messages_published.load() - published_before << " message(s) published, "
+             << dropped << " dropped, " << kept << " left in the outbox";
+
+    // A thread left behind may still publish through the clients
+    if (!stopped) {
+        return false;
+    }
+    // Stop the client loops before the routes are destroyed, so no response
+    // callback runs into a half-destroyed route
+    for (const auto& route : g_publish_routes) {
+        route->transport->shutdown();
+    }
+    return true;
+}
+
 /**
  * Health check handler
  */
@@ -343,12 +948,175 @@ void healthCheck(const HttpRequestPtr& req,
     callback(HttpResponse::newHttpJsonResponse(json));
 }
 
+/**
+ * Prometheus metrics handler
+ */
+void metricsHandler(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback) {
+    std::vector<MetricsGauge> gauges;
+    if (g_pubsub_ready.load(std::memory_order_acquire)) {
+        // Summed over routes
+        size_t depth = 0;
+        size_t in_flight = 0;
+        size_t outbox_pending = 0;
+        for (const auto& route : g_publish_routes) {
+            depth += route->executor->depth();
+            in_flight += route->in_flight ? route->in_flight->inFlight() : 0;
+            outbox_pending += route->outbox ? route->outbox->pending() : 0;
+        }
+        gauges.push_back({"pubsub_publish_queue_depth", "Batches waiting for a publish worker",
+                          static_cast<double>(depth)});
+        if (g_pubsub_settings.async) {
+            gauges.push_back({"pubsub_publish_in_flight", "Publish calls awaiting a response",
+                              static_cast<double>(in_flight)});
+        }
+        if (g_pubsub_settings.outbox) {
+            gauges.push_back({"pubsub_outbox_pending_messages",
+                              "Messages waiting in the outbox for a publish retry",
+                              static_cast<double>(outbox_pending)});
+        }
+    } else if (g_pubsub_enabled) {
+        std::lock_guard<std::mutex> lock(g_pubsub_start_mutex);
+        gauges.push_back({"pubsub_startup_pending_messages",
+                          "Messages held while the publisher starts",
+                          static_cast<double>(g_pubsub_pending.size())});
+    }
+
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setContentTypeCode(CT_TEXT_PLAIN);
+    resp->setBody(renderMetrics(gauges));
+    callback(resp);
+}
+
+#ifdef ENABLE_PROFILING
+/**
+ * JSON error response for the /debug/pprof handlers
+ */
+HttpResponsePtr pprofError(HttpStatusCode status, const char* message) {
+    Json::Value json;
+    json["error"] = message;
+    auto resp = HttpResponse::newHttpJsonResponse(json);
+    resp->setStatusCode(status);
+    return resp;
+}
+
+/**
+ * Profile as a file download for `pprof <binary> <file>`
+ */
+HttpResponsePtr pprofDownload(std::string profile, const char* filename) {
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setContentTypeCode(CT_APPLICATION_OCTET_STREAM);
+    resp->addHeader("Content-Disposition",
+                    std::string("attachment; filename=\"") + filename + "\"");
+    resp->setBody(std::move(profile));
+    return resp;
+}
+
+/**
+ * Check "Authorization: Bearer <PPROF_TOKEN>". Both sides are compared as
+ * hashes in constant time, so neither the token nor its length leaks.
+ */
+bool pprofAuthorized(const HttpRequestPtr& req) {
+    constexpr std::string_view BEARER = "Bearer ";
+    const std::string& auth = req->getHeader("authorization");
+    if (auth.size() <= BEARER.size() || auth.compare(0, BEARER.size(), BEARER) != 0) {
+        return false;
+    }
+    std::array<unsigned char, crypto_generichash_BYTES> hash;
+    crypto_generichash(hash.data(), hash.size(),
+                       reinterpret_cast<const unsigned char*>(auth.data()) + BEARER.size(),
+                       auth.size() - BEARER.size(), nullptr, 0);
+    return sodium_memcmp(hash.data(), g_pprof_token_hash.data(), hash.size()) == 0;
+}
+
+/**
+ * Start a profile, answer with it once ?seconds= (at most
+ * MAX_PPROF_SECONDS) have passed. The IO loop keeps serving in the
+ * meantime; the timer holds the callback, and stopping the profile and
+ * reading it back happen on a detached thread so the loop never waits on
+ * the file.
+ */
+void runPprofWindow(const HttpRequestPtr& req,
+                    std::function<void(const HttpResponsePtr&)>&& callback, bool (*start)(),
+                    std::string (*stop)(), const char* filename) {
+    if (!pprofAuthorized(req)) {
+        callback(pprofError(k401Unauthorized, "unauthorized"));
+        return;
+    }
+    long seconds = DEFAULT_PPROF_SECONDS;
+    const std::string& seconds_str = req->getParameter("seconds");
+    if (!seconds_str.empty()) {
+        char* end = nullptr;
+        seconds = std::strtol(seconds_str.c_str(), &end, 10);
+        if (*end != '\0' || seconds <= 0) {
+            callback(pprofError(k400BadRequest, "seconds must be a positive integer"));
+            return;
+        }
+        seconds = std::min(seconds, MAX_PPROF_SECONDS);
+    }
+    if (!start()) {
+        callback(pprofError(k409Conflict, "profile already running"));
+        return;
+    }
+    LOG_INFO << "Collecting " << filename << " for " << seconds << " s";
+    trantor::EventLoop::getEventLoopOfCurrentThread()->runAfter(
+        static_cast<double>(seconds),
+        [callback = std::move(callback), stop, filename]() mutable {
+            std::thread([callback = std::move(callback), stop, filename]() {
+                callback(pprofDownload(stop(), filename));
+            }).detach();
+        });
+}
+
+/**
+ * CPU profile over ?seconds= (default 30, at most 120)
+ */
+void pprofProfileHandler(const HttpRequestPtr& req,
+                         std::function<void(const HttpResponsePtr&)>&& callback) {
+    runPprofWindow(req, std::move(callback), &startCpuProfile, &stopCpuProfile, "cpu.pprof");
+}
+
+/**
+ * Every allocation made over ?seconds= (default 30, at most 120)
+ */
+void pprofAllocsHandler(const HttpRequestPtr& req,
+                        std::function<void(const HttpResponsePtr&)>&& callback) {
+    runPprofWindow(req, std::move(callback), &startAllocationProfile, &stopAllocationProfile,
+                   "allocs.pprof");
+}
+
+/**
+ * Sampled live heap right now
+ */
+void pprofHeapHandler(const HttpRequestPtr& req,
+                      std::function<void(const HttpResponsePtr&)>&& callback) {
+    if (!pprofAuthorized(req)) {
+        callback(pprofError(k401Unauthorized, "unauthorized"));
+        return;
+    }
+    callback(pprofDownload(heapProfile(), "heap.pprof"));
+}
+#endif
+
 int main() {
+    markStartupPhase(StartupPhase::Main);
+
+    // Route Drogon/trantor log lines through the async JSON writer
+    if (getEnvBool("LOG_ASYNC", true)) {
+        g_log_sink = std::make_unique<AsyncLogSink>(STDOUT_FILENO);
+        AsyncLogSink* sink = g_log_sink.get();
+        trantor::Logger::setOutputFunction(
+            [sink](const char* msg, uint64_t len) { sink->push(msg, len); }, []() {});
+        setStructuredLogSink(sink);
+    }
+    g_log_success_sample = getEnvSize("LOG_SUCCESS_SAMPLE", 1);
+
     // Initialize libsodium
     if (sodium_init() < 0) {
         std::cerr << "Failed to initialize libsodium" << std::endl;
         return 1;
     }
+    markStartupPhase(StartupPhase::SodiumInit);
 
     // Load configuration from environment
     const char* port_str = std::getenv("PORT");
@@ -360,42 +1128,288 @@ int main() {
         return 1;
     }
 
-    try {
-        g_public_key = hexToBytes(public_key_hex);
-        if (g_public_key.size() != crypto_sign_PUBLICKEYBYTES) {
-            std::cerr << "Invalid DISCORD_PUBLIC_KEY length" << std::endl;
+    // Decode and validate the key once; requests only use the prepared state
+    std::string key_error;
+    if (!g_verifier.setPublicKey(public_key_hex, key_error)) {
+        std::cerr << "Invalid DISCORD_PUBLIC_KEY " << key_error << std::endl;
+        return 1;
+    }
+    g_verifier.setVerdictCache(getEnvBool("SIGNATURE_CACHE", true));
+
+    // Opt-in profiling endpoints behind a bearer token
+    const char* pprof_token = std::getenv("PPROF_TOKEN");
+    bool pprof = pprof_token && *pprof_token;
+    if (pprof) {
+#ifdef ENABLE_PROFILING
+        if (std::strlen(pprof_token) < MIN_PPROF_TOKEN_LENGTH) {
+            std::cerr << "PPROF_TOKEN must be at least " << MIN_PPROF_TOKEN_LENGTH
+                      << " characters" << std::endl;
             return 1;
         }
-    } catch (...) {
-        std::cerr << "Invalid DISCORD_PUBLIC_KEY format" << std::endl;
+        crypto_generichash(g_pprof_token_hash.data(), g_pprof_token_hash.size(),
+                           reinterpret_cast<const unsigned char*>(pprof_token),
+                           std::strlen(pprof_token), nullptr, 0);
+        if (!std::getenv("TCMALLOC_SAMPLE_PARAMETER")) {
+            LOG_WARN << "TCMALLOC_SAMPLE_PARAMETER not set, /debug/pprof/heap will be empty";
+        }
+#else
+        LOG_WARN << "PPROF_TOKEN set but the server was built without PROFILING; "
+                    "/debug/pprof disabled";
+        pprof = false;
+#endif
+    }
+
+    const char* parser_str = std::getenv("INTERACTION_PARSER");
+    if (parser_str && !parseParserBackend(parser_str, g_parser_backend)) {
+        std::cerr << "Invalid INTERACTION_PARSER (expected scan or jsoncpp)" << std::endl;
         return 1;
     }
 
+    markStartupPhase(StartupPhase::Config);
+
     // Optional Pub/Sub configuration
     const char* project_id = std::getenv("GOOGLE_CLOUD_PROJECT");
     const char* topic_name = std::getenv("PUBSUB_TOPIC");
     const char* emulator_host = std::getenv("PUBSUB_EMULATOR_HOST");
+    const char* transport_str = std::getenv("PUBSUB_TRANSPORT");
+    const char* endpoint = std::getenv("PUBSUB_ENDPOINT");
     if (project_id)
         g_project_id = project_id;
     if (topic_name)
         g_pubsub_topic = topic_name;
     if (emulator_host)
         g_pubsub_emulator_host = emulator_host;
+    if (endpoint)
+        g_pubsub_endpoint = endpoint;
+    std::string transport = transport_str ? transport_str : "rest";
+
+    // Production Pub/Sub is opt-in via PUBSUB_TRANSPORT; otherwise only the emulator is used
+    g_pubsub_enabled = !g_project_id.empty() && !g_pubsub_topic.empty() &&
+                       (!g_pubsub_emulator_host.empty() || transport_str != nullptr);
+    if (transport != "rest" && transport != "grpc") {
+        std::cerr << "Invalid PUBSUB_TRANSPORT (expected rest or grpc)" << std::endl;
+        return 1;
+    }
+#ifndef ENABLE_PUBSUB_GRPC
+    if (g_pubsub_enabled && transport == "grpc") {
+        std::cerr << "PUBSUB_TRANSPORT=grpc requires a build with -DPUBSUB_GRPC=ON" << std::endl;
+        return 1;
+    }
+#endif
 
-    if (!g_pubsub_emulator_host.empty() && !g_project_id.empty() && !g_pubsub_topic.empty()) {
-        std::cout << "Pub/Sub configured: " << g_pubsub_emulator_host << " project=" << g_project_id
-                  << " topic=" << g_pubsub_topic << std::endl;
+    // PUBSUB_INIT=lazy (default) builds the publisher stack after the listener is up
+    const char* init_str = std::getenv("PUBSUB_INIT");
+    std::string init_mode = init_str ? init_str : "lazy";
+    if (init_mode != "lazy" && init_mode != "eager") {
+        std::cerr << "Invalid PUBSUB_INIT (expected lazy or eager)" << std::endl;
+        return 1;
     }
 
+    if (g_pubsub_enabled) {
+        LOG_INFO << "Pub/Sub configured: "
+                 << (g_pubsub_emulator_host.empty() ? g_pubsub_endpoint : g_pubsub_emulator_host)
+                 << " project=" << g_project_id << " topic=" << g_pubsub_topic
+                 << " transport=" << transport << " init=" << init_mode;
+
+        PubSubSettings& settings = g_pubsub_settings;
+        settings.transport = transport;
+        settings.workers = getEnvSize("PUBSUB_WORKERS", DEFAULT_PUBSUB_WORKERS);
+        settings.queue_depth = getEnvSize("PUBSUB_QUEUE_DEPTH", DEFAULT_PUBSUB_QUEUE_DEPTH);
+        const char* overflow_str = std::getenv("PUBSUB_QUEUE_OVERFLOW");
+        if (overflow_str && !parseOverflowPolicy(overflow_str, settings.overflow)) {
+            LOG_WARN << "Ignoring invalid PUBSUB_QUEUE_OVERFLOW=" << overflow_str;
+        }
+        // Full batches are handed to the executor on the HTTP loop that added
+        // the last message; blocking there would stall every request on it
+        if (settings.overflow == OverflowPolicy::Block) {
+            std::cerr << "PUBSUB_QUEUE_OVERFLOW=block is not supported: it would stall the IO "
+                         "loops (expected drop-oldest or drop-new)"
+                      << std::endl;
+            return 1;
+        }
+
+        // Async publishing (PUBSUB_ASYNC, on by default) hands requests to the
+        // client loops and caps how many await a response. Synchronous workers
+        // hold one request each, so they get one keep-alive connection each.
+        settings.async = getEnvBool("PUBSUB_ASYNC", true);
+        settings.max_in_flight = getEnvSize("PUBSUB_MAX_IN_FLIGHT", DEFAULT_PUBSUB_MAX_IN_FLIGHT);
+        settings.connections =
+            getEnvSize("PUBSUB_CONNECTIONS",
+                       settings.async ? DEFAULT_PUBSUB_ASYNC_CONNECTIONS : settings.workers);
+
+        if (transport == "grpc") {
+            settings.batch.max_delay = DEFAULT_GRPC_BATCH_DELAY;
+        }
+
+        // Admission control (PUBSUB_SHED, on by default): refuse commands
+        // once publish queue waits stay above the target for a full interval
+        OverloadConfig& overload = settings.overload;
+        overload.target = std::chrono::milliseconds(
+            getEnvSize("PUBSUB_SHED_TARGET_MS", overload.target.count()));
+        overload.interval = std::chrono::milliseconds(
+            getEnvSize("PUBSUB_SHED_INTERVAL_MS", overload.interval.count()));
+        if (!getEnvBool("PUBSUB_SHED", true)) {
+            overload.target = std::chrono::milliseconds(0);
+        }
+
+        settings.outbox = getEnvBool("PUBSUB_OUTBOX", true);
+        if (const char* outbox_path = std::getenv("PUBSUB_OUTBOX_PATH")) {
+            settings.outbox_path = outbox_path;
+        }
+        settings.outbox_bytes = getEnvSize("PUBSUB_OUTBOX_BYTES", DEFAULT_PUBSUB_OUTBOX_BYTES);
+        settings.drain =
+            std::chrono::milliseconds(getEnvSize("PUBSUB_DRAIN_MS", settings.drain.count()));
+
+        // Commands listed in PUBSUB_ROUTES get their own topic and pipeline;
+        // the rest share PUBSUB_TOPIC's
+        const char* routes_str = std::getenv("PUBSUB_ROUTES");
+        std::string routes_error;
+        if (!g_topic_router.configure(g_pubsub_topic, routes_str ? routes_str : "",
+                                      routes_error)) {
+            std::cerr << "Invalid PUBSUB_ROUTES: " << routes_error << std::endl;
+            return 1;
+        }
+        for (const std::string& topic : g_topic_router.topics()) {
+            settings.routes.push_back(
+                resolveRouteSettings(settings, topic, settings.routes.empty()));
+        }
+
+        // Publish each interaction id once (PUBSUB_DEDUP, on by default);
+        // memory is fixed by the entry count
+        if (getEnvBool("PUBSUB_DEDUP", true)) {
+            size_t entries = getEnvSize("PUBSUB_DEDUP_ENTRIES", DEFAULT_PUBSUB_DEDUP_ENTRIES);
+            size_t ttl = getEnvSize("PUBSUB_DEDUP_TTL_SECONDS", DEFAULT_PUBSUB_DEDUP_TTL_SECONDS);
+            g_idempotency_cache =
+                std::make_unique<IdempotencyCache>(entries, std::chrono::seconds(ttl));
+            LOG_INFO << "Pub/Sub dedup entries=" << entries << " ttl_s=" << ttl
+                     << " bytes=" << g_idempotency_cache->memoryBytes();
+        }
+
+        LOG_INFO << "Pub/Sub overflow=" << overflowPolicyName(settings.overflow)
+                 << " async=" << settings.async << " shed_target_ms=" << overload.target.count()
+                 << " shed_interval_ms=" << overload.interval.count()
+                 << " drain_ms=" << settings.drain.count();
+        for (const RouteSettings& route : settings.routes) {
+            LOG_INFO << "Pub/Sub route topic=" << route.topic << " workers=" << route.workers
+                     << " queue_depth=" << route.queue_depth
+                     << " connections=" << route.connections
+                     << " max_in_flight=" << route.max_in_flight
+                     << " batch_messages=" << route.batch.max_messages
+                     << " batch_bytes=" << route.batch.max_bytes
+                     << " batch_delay_ms=" << route.batch.max_delay.count();
+            if (settings.outbox) {
+                LOG_INFO << "Pub/Sub outbox topic=" << route.topic << " path="
+                         << (route.outbox_path.empty() ? "(memory)" : route.outbox_path)
+                         << " bytes=" << route.outbox_bytes;
+            }
+        }
+
+        if (init_mode == "eager") {
+            if (!startPubSub()) {
+                return 1;
+            }
+        } else {
+            g_pubsub_start_thread = std::thread([]() {
+                bool start = false;
+                {
+                    std::unique_lock<std::mutex> lock(g_pubsub_start_mutex);
+                    g_pubsub_start_cv.wait(lock, []() {
+                        return g_pubsub_start_requested.load() || g_pubsub_start_cancelled;
+                    });
+                    start = g_pubsub_start_requested.load();
+                }
+                if (start && !startPubSub()) {
+                    LOG_ERROR << "Pub/Sub failed to start";
+                }
+                {
+                    std::lock_guard<std::mutex> lock(g_pubsub_start_mutex);
+                    g_pubsub_start_finished = true;
+                }
+                g_pubsub_start_cv.notify_all();
+            });
+        }
+    }
+
+    markStartupPhase(StartupPhase::Subsystems);
+
+    // IO loops default to the CPU quota, not the host core count. With
+    // SO_REUSEPORT Drogon opens one listener per loop and the kernel spreads
+    // accepts across them instead of sharing one accept queue.
+    size_t io_threads = getEnvSize("DROGON_THREADS", availableCpus());
+    bool reuse_port = getEnvBool("DROGON_REUSEPORT", false);
+    bool pin_threads = getEnvBool("DROGON_PIN_THREADS", false);
+    app().setThreadNum(io_threads);
+    app().enableReusePort(reuse_port);
+    LOG_INFO << "IO threads=" << io_threads << " reuse_port=" << reuse_port
+             << " pin_threads=" << pin_threads << " pprof=" << pprof;
+
+    // The service only takes small JSON POSTs: no static files (and their
+    // .gz/.br lookups), no compression, and bodies never spill to temp files
+    app().setFileTypes({});
+    app().setGzipStatic(false);
+    app().setBrStatic(false);
+    app().enableGzip(false);
+    app().enableBrotli(false);
+    app().setClientMaxBodySize(MAX_BODY_SIZE);
+    app().setClientMaxMemoryBodySize(MAX_BODY_SIZE);
+
+    initCannedResponses();
+
     // Configure routes
     app().registerHandler("/health", &healthCheck, {Get});
+    app().registerHandler("/metrics", &metricsHandler, {Get});
+#ifdef ENABLE_PROFILING
+    if (pprof) {
+        app().registerHandler("/debug/pprof/profile", &pprofProfileHandler, {Get});
+        app().registerHandler("/debug/pprof/allocs", &pprofAllocsHandler, {Get});
+        app().registerHandler("/debug/pprof/heap", &pprofHeapHandler, {Get});
+    }
+#endif
     app().registerHandler("/", &handleInteraction, {Post});
     app().registerHandler("/interactions", &handleInteraction, {Post});
 
+    // Startup timing; the report is written once the first response is sent
+    app().registerBeginningAdvice([pin_threads]() {
+        markStartupPhase(StartupPhase::Listen);
+        if (pin_threads) {
+            pinIoLoops();
+        }
+        if (g_pubsub_start_thread.joinable()) {
+            requestPubSubStart();
+        }
+    });
+    app().registerNewConnectionAdvice(
+        [](const trantor::InetAddress&, const trantor::InetAddress&) {
+            markStartupPhase(StartupPhase::FirstConnection);
+            return true;
+        });
+    app().registerPreSendingAdvice([](const HttpRequestPtr&, const HttpResponsePtr&) {
+        markStartupPhase(StartupPhase::FirstResponse);
+    });
+    markStartupPhase(StartupPhase::Routes);
+
     // Start server
-    std::cout << "Starting server on port " << port << std::endl;
+    LOG_INFO << "Starting server on port " << port;
     app().addListener("0.0.0.0", port);
     app().run();
 
+    // Drogon stops accepting requests on SIGTERM and returns from run()
+    bool drained = !g_pubsub_enabled || drainPubSub();
+
+    // Write out remaining log lines; anything logged later goes straight to stdout
+    if (g_log_sink) {
+        setStructuredLogSink(nullptr);
+        g_log_sink->shutdown();
+        trantor::Logger::setOutputFunction(
+            [](const char* msg, uint64_t len) { fwrite(msg, 1, len, stdout); },
+            []() { fflush(stdout); });
+    }
+
+    if (!drained) {
+        // Publish threads past the deadline still use the routes; exit
+        // without running destructors under them
+        fflush(stdout);
+        std::_Exit(0);
+    }
     return 0;
 }
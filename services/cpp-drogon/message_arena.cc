@@ -0,0 +1,176 @@
+/**
+ * Recycled arenas backing Pub/Sub messages.
+ */
+
+#include "message_arena.h"
+
+#include <atomic>
+#include <new>
+
+/**
+ * Free blocks of one thread. Only the owner thread touches free_; other
+ * threads push onto returned_, which the owner takes over wholesale, so the
+ * stack never pops single nodes and has no ABA problem.
+ */
+class MessageArenaPool {
+  public:
+    // Blocks kept per thread; beyond this freed blocks go back to the heap
+    static constexpr size_t MAX_CACHED = 256;
+
+    MessageArena* take() {
+        if (!free_) {
+            adoptReturned();
+        }
+        if (!free_) {
+            return MessageArena::create(this, MessageArena::BLOCK_BYTES);
+        }
+        MessageArena* arena = free_;
+        free_ = arena->next_;
+        --cached_;
+        return arena;
+    }
+
+    /**
+     * Owner thread only
+     */
+    void give(MessageArena* arena) {
+        if (cached_ >= MAX_CACHED) {
+            MessageArena::destroy(arena);
+            return;
+        }
+        arena->next_ = free_;
+        free_ = arena;
+        ++cached_;
+    }
+
+    /**
+     * Any other thread
+     */
+    void giveBack(MessageArena* arena) {
+        MessageArena* head = returned_.load(std::memory_order_relaxed);
+        do {
+            arena->next_ = head;
+        } while (!returned_.compare_exchange_weak(head, arena));
+        // Owner gone: nobody will adopt the stack, so empty it here
+        if (orphaned_.load()) {
+            destroyList(returned_.exchange(nullptr));
+        }
+    }
+
+    /**
+     * Owner thread exit. The pool itself stays allocated, since blocks still
+     * in flight point at it; their release frees them from then on. It is
+     * linked onto retired so it stays reachable rather than leaked.
+     */
+    void orphan(std::atomic<MessageArenaPool*>& retired) {
+        destroyList(free_);
+        free_ = nullptr;
+        cached_ = 0;
+        orphaned_.store(true);
+        destroyList(returned_.exchange(nullptr));
+        next_retired_ = retired.load(std::memory_order_relaxed);
+        while (!retired.compare_exchange_weak(next_retired_, this)) {
+        }
+    }
+
+  private:
+    void adoptReturned() {
+        MessageArena* list = returned_.exchange(nullptr, std::memory_order_acquire);
+        while (list) {
+            MessageArena* next = list->next_;
+            give(list);
+            list = next;
+        }
+    }
+
+    static void destroyList(MessageArena* list) {
+        while (list) {
+            MessageArena* next = list->next_;
+            MessageArena::destroy(list);
+            list = next;
+        }
+    }
+
+    MessageArena* free_ = nullptr;
+    size_t cached_ = 0;
+    std::atomic<MessageArena*> returned_{nullptr};
+    std::atomic<bool> orphaned_{false};
+    MessageArenaPool* next_retired_ = nullptr;
+};
+
+namespace {
+
+// Pools of exited threads, never freed
+std::atomic<MessageArenaPool*> g_retired_pools{nullptr};
+
+thread_local MessageArenaPool* t_pool = nullptr;
+thread_local bool t_exited = false;
+
+struct PoolExit {
+    ~PoolExit() {
+        t_exited = true;
+        if (t_pool) {
+            t_pool->orphan(g_retired_pools);
+            t_pool = nullptr;
+        }
+    }
+};
+
+/**
+ * This thread's pool, or null once the thread is exiting
+ */
+MessageArenaPool* threadPool() {
+    if (!t_pool && !t_exited) {
+        thread_local PoolExit exit;
+        t_pool = new MessageArenaPool;
+    }
+    return t_pool;
+}
+
+}  // namespace
+
+MessageArena::MessageArena(MessageArenaPool* owner, size_t capacity)
+    : owner_(owner),
+      capacity_(capacity),
+      resource_(buffer(), capacity, std::pmr::new_delete_resource()) {}
+
+MessageArena* MessageArena::create(MessageArenaPool* owner, size_t capacity) {
+    void* memory = ::operator new(sizeof(MessageArena) + capacity);
+    return new (memory) MessageArena(owner, capacity);
+}
+
+void MessageArena::destroy(MessageArena* arena) {
+    arena->~MessageArena();
+    ::operator delete(arena);
+}
+
+void MessageArena::reset() {
+    resource_.~monotonic_buffer_resource();
+    new (&resource_) std::pmr::monotonic_buffer_resource(buffer(), capacity_,
+                                                         std::pmr::new_delete_resource());
+}
+
+MessageArena* MessageArena::acquire(size_t bytes) {
+    MessageArenaPool* pool = bytes <= BLOCK_BYTES ? threadPool() : nullptr;
+    if (!pool) {
+        return create(nullptr, bytes < BLOCK_BYTES ? BLOCK_BYTES : bytes);
+    }
+    return pool->take();
+}
+
+void MessageArena::release(MessageArena* arena) {
+    if (!arena) {
+        return;
+    }
+    MessageArenaPool* owner = arena->owner_;
+    if (!owner) {
+        destroy(arena);
+        return;
+    }
+    arena->reset();
+    if (owner == t_pool) {
+        owner->give(arena);
+    } else {
+        owner->giveBack(arena);
+    }
+}
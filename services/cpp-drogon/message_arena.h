@@ -0,0 +1,77 @@
+/**
+ * Recycled arenas backing Pub/Sub messages.
+ *
+ * Messages are built on the IO loops but freed wherever their batch is
+ * settled: a publish worker, a client loop, the outbox retry thread. Going
+ * through malloc for every message would free each block on a different
+ * thread from the one that allocated it, which is where allocators contend.
+ * Instead every thread keeps a pool of fixed-size blocks. A block goes back
+ * to the pool of the thread that took it: directly when it is freed on that
+ * thread, otherwise onto a lock-free return stack that the owner takes over
+ * in one exchange the next time its own free list runs dry. In steady state
+ * building and freeing a message touches no allocator at all.
+ *
+ * Requests too large for a pooled block get a dedicated heap block.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+class MessageArenaPool;
+
+class alignas(std::max_align_t) MessageArena {
+  public:
+    // Pooled block space; covers sanitized interactions with their attributes
+    static constexpr size_t BLOCK_BYTES = 8192;
+
+    /**
+     * Take an arena with at least bytes of space from this thread's pool
+     */
+    static MessageArena* acquire(size_t bytes);
+
+    /**
+     * Hand an arena back to the pool it came from; safe on any thread.
+     * Everything allocated from it must already be destroyed.
+     */
+    static void release(MessageArena* arena);
+
+    MessageArena(const MessageArena&) = delete;
+    MessageArena& operator=(const MessageArena&) = delete;
+
+    std::pmr::memory_resource* resource() {
+        return &resource_;
+    }
+
+  private:
+    friend class MessageArenaPool;
+
+    MessageArena(MessageArenaPool* owner, size_t capacity);
+
+    static MessageArena* create(MessageArenaPool* owner, size_t capacity);
+    static void destroy(MessageArena* arena);
+
+    /**
+     * Start over at the beginning of the block; overflow chunks are freed
+     */
+    void reset();
+
+    unsigned char* buffer() {
+        return reinterpret_cast<unsigned char*>(this + 1);
+    }
+
+    MessageArenaPool* owner_;  // Null for dedicated blocks
+    MessageArena* next_ = nullptr;
+    size_t capacity_;
+    std::pmr::monotonic_buffer_resource resource_;
+};
+
+struct MessageArenaDeleter {
+    void operator()(MessageArena* arena) const {
+        MessageArena::release(arena);
+    }
+};
+
+using MessageArenaPtr = std::unique_ptr<MessageArena, MessageArenaDeleter>;
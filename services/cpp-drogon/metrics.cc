@@ -0,0 +1,262 @@
+/**
+ * Hot-path metrics with Prometheus text exposition.
+ */
+
+#include "metrics.h"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace {
+
+// Log-linear buckets: exact below SUB_COUNT, then SUB_COUNT per power of two
+constexpr int SUB_BITS = 2;
+constexpr uint64_t SUB_COUNT = uint64_t{1} << SUB_BITS;
+constexpr int MAX_OCTAVE = 40;  // ~18 minutes in nanoseconds; larger values are clamped
+constexpr size_t FINE_BUCKETS = (MAX_OCTAVE - SUB_BITS + 1) * SUB_COUNT + SUB_COUNT;
+
+// Status codes tracked individually; anything else lands in the last slot
+constexpr size_t STATUS_SLOTS = 600;
+
+// Failure codes are kept per transport: HTTP and gRPC codes overlap (14 is
+// gRPC UNAVAILABLE), so they are labelled apart
+constexpr std::array<const char*, 2> TRANSPORT_NAMES = {"rest", "grpc"};
+
+constexpr std::array<const char*, LATENCY_METRIC_COUNT> LATENCY_NAMES = {
+    "discord_signature_verify_seconds",
+    "discord_interaction_parse_seconds",
+    "discord_handler_seconds",
+    "pubsub_publish_seconds",
+};
+constexpr std::array<const char*, LATENCY_METRIC_COUNT> LATENCY_HELP = {
+    "Signature verification time",
+    "Interaction body parse time",
+    "Interaction handler time",
+    "Pub/Sub publish call time per batch",
+};
+
+/**
+ * Add to a counter only the owning thread writes (plain load + store, no lock prefix)
+ */
+inline void bump(std::atomic<uint64_t>& counter, uint64_t by = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+/**
+ * Fine bucket for x, so that a value v = x + 1 lands in (2^k, 2^(k+1)] octaves
+ * and every power of two is an exact cumulative boundary
+ */
+size_t fineIndex(uint64_t x) {
+    if (x < SUB_COUNT) {
+        return static_cast<size_t>(x);
+    }
+    int msb = 63 - __builtin_clzll(x);
+    if (msb > MAX_OCTAVE) {
+        return FINE_BUCKETS - 1;
+    }
+    int shift = msb - SUB_BITS;
+    return (static_cast<size_t>(msb - SUB_BITS + 1) << SUB_BITS) +
+           ((x >> shift) & (SUB_COUNT - 1));
+}
+
+/**
+ * Number of fine buckets holding values <= 2^k
+ */
+size_t bucketsAtOrBelow(int k) {
+    if (k < SUB_BITS) {
+        return size_t{1} << k;
+    }
+    return static_cast<size_t>(k - SUB_BITS + 1) << SUB_BITS;
+}
+
+struct Histogram {
+    std::atomic<uint64_t> zero{0};
+    std::array<std::atomic<uint64_t>, FINE_BUCKETS> buckets{};
+    std::atomic<uint64_t> sum{0};
+
+    void record(uint64_t value) {
+        if (value == 0) {
+            bump(zero);
+        } else {
+            bump(buckets[fineIndex(value - 1)]);
+        }
+        bump(sum, value);
+    }
+};
+
+struct alignas(64) Shard {
+    std::array<Histogram, LATENCY_METRIC_COUNT> latency;
+    Histogram batch_size;
+    std::atomic<uint64_t> publish_ok{0};
+    std::array<std::array<std::atomic<uint64_t>, STATUS_SLOTS + 1>, TRANSPORT_NAMES.size()>
+        publish_failures{};
+    std::atomic<uint64_t> shed{0};
+    std::atomic<uint64_t> duplicates{0};
+};
+
+std::mutex g_shards_mutex;
+std::vector<std::unique_ptr<Shard>> g_shards;
+
+/**
+ * The calling thread's shard; registered on first use and kept past thread
+ * exit so its counts stay in the totals
+ */
+Shard& localShard() {
+    thread_local Shard* shard = []() {
+        auto created = std::make_unique<Shard>();
+        Shard* raw = created.get();
+        std::lock_guard<std::mutex> lock(g_shards_mutex);
+        g_shards.push_back(std::move(created));
+        return raw;
+    }();
+    return *shard;
+}
+
+/**
+ * Sum of one histogram across shards
+ */
+struct HistogramTotals {
+    uint64_t zero = 0;
+    std::array<uint64_t, FINE_BUCKETS> buckets{};
+    uint64_t sum = 0;
+
+    void add(const Histogram& h) {
+        zero += h.zero.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < FINE_BUCKETS; ++i) {
+            buckets[i] += h.buckets[i].load(std::memory_order_relaxed);
+        }
+        sum += h.sum.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Write a histogram with cumulative buckets at 2^first_k .. 2^last_k native
+ * units, scaled by unit (e.g. 1e-9 for nanoseconds to seconds)
+ */
+void writeHistogram(std::ostringstream& out, const char* name, const char* help,
+                    const HistogramTotals& totals, int first_k, int last_k, double unit) {
+    out << "# HELP " << name << ' ' << help << '\n';
+    out << "# TYPE " << name << " histogram\n";
+
+    uint64_t cumulative = totals.zero;
+    size_t next = 0;
+    for (int k = first_k; k <= last_k; ++k) {
+        for (size_t end = bucketsAtOrBelow(k); next < end; ++next) {
+            cumulative += totals.buckets[next];
+        }
+        out << name << "_bucket{le=\"" << static_cast<double>(uint64_t{1} << k) * unit << "\"} "
+            << cumulative << '\n';
+    }
+    for (; next < FINE_BUCKETS; ++next) {
+        cumulative += totals.buckets[next];
+    }
+    out << name << "_bucket{le=\"+Inf\"} " << cumulative << '\n';
+    out << name << "_sum " << static_cast<double>(totals.sum) * unit << '\n';
+    out << name << "_count " << cumulative << '\n';
+}
+
+}  // namespace
+
+void recordLatency(LatencyMetric metric, std::chrono::nanoseconds duration) {
+    int64_t ns = duration.count();
+    localShard().latency[static_cast<size_t>(metric)].record(ns > 0 ? ns : 0);
+}
+
+void recordPublish(size_t batch_size, bool ok, int code, const char* transport) {
+    Shard& shard = localShard();
+    shard.batch_size.record(batch_size);
+    if (ok) {
+        bump(shard.publish_ok);
+    } else {
+        size_t kind = std::strcmp(transport, TRANSPORT_NAMES[1]) == 0 ? 1 : 0;
+        size_t slot = code >= 0 && static_cast<size_t>(code) < STATUS_SLOTS ? code : STATUS_SLOTS;
+        bump(shard.publish_failures[kind][slot]);
+    }
+}
+
+void recordShed() {
+    bump(localShard().shed);
+}
+
+void recordDuplicate() {
+    bump(localShard().duplicates);
+}
+
+std::string renderMetrics(const std::vector<MetricsGauge>& gauges) {
+    std::array<HistogramTotals, LATENCY_METRIC_COUNT> latency;
+    HistogramTotals batch_size;
+    uint64_t publish_ok = 0;
+    std::array<std::array<uint64_t, STATUS_SLOTS + 1>, TRANSPORT_NAMES.size()> publish_failures{};
+    uint64_t shed = 0;
+    uint64_t duplicates = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_shards_mutex);
+        for (const auto& shard : g_shards) {
+            for (size_t i = 0; i < LATENCY_METRIC_COUNT; ++i) {
+                latency[i].add(shard->latency[i]);
+            }
+            batch_size.add(shard->batch_size);
+            publish_ok += shard->publish_ok.load(std::memory_order_relaxed);
+            for (size_t t = 0; t < TRANSPORT_NAMES.size(); ++t) {
+                for (size_t i = 0; i <= STATUS_SLOTS; ++i) {
+                    publish_failures[t][i] +=
+                        shard->publish_failures[t][i].load(std::memory_order_relaxed);
+                }
+            }
+            shed += shard->shed.load(std::memory_order_relaxed);
+            duplicates += shard->duplicates.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::ostringstream out;
+    out.precision(12);
+    // 1.024us .. ~17s
+    for (size_t i = 0; i < LATENCY_METRIC_COUNT; ++i) {
+        writeHistogram(out, LATENCY_NAMES[i], LATENCY_HELP[i], latency[i], 10, 34, 1e-9);
+    }
+    writeHistogram(out, "pubsub_batch_messages", "Messages per Pub/Sub publish call", batch_size,
+                   0, 10, 1.0);
+
+    out << "# HELP pubsub_publish_success_total Successful Pub/Sub publish calls\n";
+    out << "# TYPE pubsub_publish_success_total counter\n";
+    out << "pubsub_publish_success_total " << publish_ok << '\n';
+
+    out << "# HELP pubsub_publish_failures_total Failed Pub/Sub publish calls by transport and "
+           "status code (HTTP for rest, gRPC for grpc)\n";
+    out << "# TYPE pubsub_publish_failures_total counter\n";
+    for (size_t t = 0; t < TRANSPORT_NAMES.size(); ++t) {
+        for (size_t i = 0; i <= STATUS_SLOTS; ++i) {
+            if (publish_failures[t][i] == 0) {
+                continue;
+            }
+            out << "pubsub_publish_failures_total{transport=\"" << TRANSPORT_NAMES[t]
+                << "\",code=\"";
+            if (i == STATUS_SLOTS) {
+                out << "other";
+            } else {
+                out << i;
+            }
+            out << "\"} " << publish_failures[t][i] << '\n';
+        }
+    }
+
+    out << "# HELP discord_interactions_shed_total Interactions rejected while overloaded\n";
+    out << "# TYPE discord_interactions_shed_total counter\n";
+    out << "discord_interactions_shed_total " << shed << '\n';
+
+    out << "# HELP discord_interactions_duplicate_total Redelivered interactions not published "
+           "again\n";
+    out << "# TYPE discord_interactions_duplicate_total counter\n";
+    out << "discord_interactions_duplicate_total " << duplicates << '\n';
+
+    for (const auto& gauge : gauges) {
+        out << "# HELP " << gauge.name << ' ' << gauge.help << '\n';
+        out << "# TYPE " << gauge.name << " gauge\n";
+        out << gauge.name << ' ' << gauge.value << '\n';
+    }
+    return out.str();
+}
@@ -0,0 +1,84 @@
+/**
+ * Hot-path metrics with Prometheus text exposition.
+ *
+ * Every recording thread (IO loops, publish workers) owns a shard of
+ * counters and log-linear histograms. Only the owning thread writes a shard,
+ * using relaxed load/store pairs rather than read-modify-write atomics, so
+ * recording touches no cache line shared with another thread. A scrape
+ * walks all shards and sums them; counts may lag by a recording, never tear.
+ *
+ * Histograms keep four sub-buckets per power of two (worst-case relative
+ * error 25%) and export cumulative buckets at powers of two.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class LatencyMetric {
+    SignatureVerify,  // validateSignature, including timestamp and hex checks
+    Parse,            // Interaction body parse
+    Handler,          // Whole interaction handler
+    Publish,          // One Pub/Sub publish call, per batch
+};
+constexpr size_t LATENCY_METRIC_COUNT = 4;
+
+/**
+ * Record a duration on the calling thread's shard
+ */
+void recordLatency(LatencyMetric metric, std::chrono::nanoseconds duration);
+
+/**
+ * Record the size and outcome of one publish call.
+ * code is the transport status (HTTP for "rest", gRPC for "grpc"), or 0
+ * for no response; transport is PubSubTransport::name().
+ */
+void recordPublish(size_t batch_size, bool ok, int code, const char* transport);
+
+/**
+ * Count one interaction turned away by admission control
+ */
+void recordShed();
+
+/**
+ * Count one redelivered interaction answered without publishing
+ */
+void recordDuplicate();
+
+/**
+ * Times a scope and records it on destruction
+ */
+class ScopedLatency {
+  public:
+    explicit ScopedLatency(LatencyMetric metric)
+        : metric_(metric), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedLatency() {
+        recordLatency(metric_, std::chrono::steady_clock::now() - start_);
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+  private:
+    LatencyMetric metric_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Point-in-time value sampled by the caller at scrape time
+ */
+struct MetricsGauge {
+    const char* name;
+    const char* help;
+    double value;
+};
+
+/**
+ * Render all shards plus the given gauges in Prometheus text format
+ */
+std::string renderMetrics(const std::vector<MetricsGauge>& gauges);
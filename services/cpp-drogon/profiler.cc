@@ -0,0 +1,101 @@
+/**
+ * On-demand CPU and heap profiles in pprof's legacy formats.
+ */
+
+#include "profiler.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <gperftools/heap-profiler.h>
+#include <gperftools/malloc_extension.h>
+#include <gperftools/profiler.h>
+#include <iterator>
+#include <mutex>
+#include <unistd.h>
+
+namespace {
+
+std::mutex g_cpu_mutex;
+std::string g_cpu_path;  // Set while a CPU profile is running
+
+std::mutex g_alloc_mutex;
+std::string g_alloc_dir;  // Set while an allocation profile is running
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+bool startCpuProfile() {
+    std::lock_guard<std::mutex> lock(g_cpu_mutex);
+    if (!g_cpu_path.empty()) {
+        return false;
+    }
+    // The profiler only writes to a file; keep it private and remove it after
+    char path[] = "/tmp/cpu-profile-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    if (!ProfilerStart(path)) {
+        unlink(path);
+        return false;
+    }
+    g_cpu_path = path;
+    return true;
+}
+
+std::string stopCpuProfile() {
+    std::lock_guard<std::mutex> lock(g_cpu_mutex);
+    if (g_cpu_path.empty()) {
+        return {};
+    }
+    ProfilerStop();
+    std::string profile = readFile(g_cpu_path);
+    unlink(g_cpu_path.c_str());
+    g_cpu_path.clear();
+    return profile;
+}
+
+std::string heapProfile() {
+    std::string profile;
+    MallocExtension::instance()->GetHeapSample(&profile);
+    return profile;
+}
+
+bool startAllocationProfile() {
+    std::lock_guard<std::mutex> lock(g_alloc_mutex);
+    if (!g_alloc_dir.empty() || IsHeapProfilerRunning()) {
+        return false;
+    }
+    // The heap profiler dumps to prefix.NNNN.heap as allocations pass
+    // HEAP_PROFILE_ALLOCATION_INTERVAL; collect those in a scratch directory
+    char dir[] = "/tmp/heap-profile-XXXXXX";
+    if (!mkdtemp(dir)) {
+        return false;
+    }
+    g_alloc_dir = dir;
+    HeapProfilerStart((g_alloc_dir + "/heap").c_str());
+    return true;
+}
+
+std::string stopAllocationProfile() {
+    std::lock_guard<std::mutex> lock(g_alloc_mutex);
+    if (g_alloc_dir.empty()) {
+        return {};
+    }
+    std::string profile;
+    if (char* raw = GetHeapProfile()) {
+        profile = raw;
+        free(raw);
+    }
+    HeapProfilerStop();
+    std::error_code ignored;
+    std::filesystem::remove_all(g_alloc_dir, ignored);
+    g_alloc_dir.clear();
+    return profile;
+}
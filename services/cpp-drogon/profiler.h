@@ -0,0 +1,44 @@
+/**
+ * On-demand CPU and heap profiles in pprof's legacy formats.
+ *
+ * Backed by gperftools and only built with -DPROFILING=ON. Nothing samples
+ * until a profile is requested: the CPU profiler arms SIGPROF for the
+ * requested window only, and the heap snapshot reads tcmalloc's sampled
+ * allocations (one per TCMALLOC_SAMPLE_PARAMETER bytes, off when unset).
+ * Windowed allocation profiles hook every allocation while they run, so
+ * they cost real throughput for their duration. At most one profile of
+ * each kind runs at a time.
+ */
+
+#pragma once
+
+#include <string>
+
+/**
+ * Start sampling CPU usage. Returns false if a CPU profile is already
+ * running or the profiler could not start.
+ */
+bool startCpuProfile();
+
+/**
+ * Stop the CPU profile started by startCpuProfile() and return its contents
+ */
+std::string stopCpuProfile();
+
+/**
+ * Live heap sampled by tcmalloc; the profile has no samples when
+ * TCMALLOC_SAMPLE_PARAMETER is not set
+ */
+std::string heapProfile();
+
+/**
+ * Start recording allocations. Returns false if an allocation profile is
+ * already running or the heap profiler could not start.
+ */
+bool startAllocationProfile();
+
+/**
+ * Stop the allocation profile and return every allocation made since
+ * startAllocationProfile(), freed or not
+ */
+std::string stopAllocationProfile();
@@ -0,0 +1,99 @@
+/**
+ * Micro-batching stage in front of the Pub/Sub :publish call.
+ */
+
+#include "publish_batcher.h"
+
+#include <utility>
+
+PublishBatcher::PublishBatcher(const BatchConfig& config, FlushFn flush)
+    : config_(config), flush_(std::move(flush)) {
+    pending_.reserve(config_.max_messages);
+    timer_ = std::thread([this]() { timerLoop(); });
+}
+
+PublishBatcher::~PublishBatcher() {
+    shutdown();
+}
+
+void PublishBatcher::add(PubSubMessage message) {
+    Batch full;
+    Batch overflow;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        size_t size = message.byteSize();
+
+        // Send what we have first if this message would push us past the byte limit
+        if (!pending_.empty() && pending_bytes_ + size > config_.max_bytes) {
+            overflow = takeLocked();
+        }
+
+        if (pending_.empty()) {
+            deadline_ = std::chrono::steady_clock::now() + config_.max_delay;
+            cv_.notify_one();
+        }
+        pending_bytes_ += size;
+        pending_.push_back(std::move(message));
+
+        if (pending_.size() >= config_.max_messages || pending_bytes_ >= config_.max_bytes) {
+            full = takeLocked();
+        }
+    }
+
+    if (!overflow.empty()) {
+        flush_(std::move(overflow));
+    }
+    if (!full.empty()) {
+        flush_(std::move(full));
+    }
+}
+
+void PublishBatcher::shutdown() {
+    Batch remaining;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+        remaining = takeLocked();
+    }
+    cv_.notify_all();
+    if (timer_.joinable()) {
+        timer_.join();
+    }
+    if (!remaining.empty()) {
+        flush_(std::move(remaining));
+    }
+}
+
+PublishBatcher::Batch PublishBatcher::takeLocked() {
+    Batch batch;
+    batch.swap(pending_);
+    pending_.reserve(config_.max_messages);
+    pending_bytes_ = 0;
+    return batch;
+}
+
+void PublishBatcher::timerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (pending_.empty()) {
+            cv_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+            continue;
+        }
+
+        if (cv_.wait_until(lock, deadline_) != std::cv_status::timeout) {
+            // Woken early: batch may have been flushed or the deadline moved
+            continue;
+        }
+
+        if (!pending_.empty() && std::chrono::steady_clock::now() >= deadline_) {
+            Batch batch = takeLocked();
+            lock.unlock();
+            flush_(std::move(batch));
+            lock.lock();
+        }
+    }
+}
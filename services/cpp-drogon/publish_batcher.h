@@ -0,0 +1,74 @@
+/**
+ * Micro-batching stage in front of the Pub/Sub :publish call.
+ *
+ * Collects prepared Pub/Sub messages and hands them on as one batch once a
+ * message count, byte size, or age limit is reached, so that a single
+ * publish request carries many interactions.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "pubsub_transport.h"
+
+/**
+ * Flush thresholds for a batch (whichever is reached first)
+ */
+struct BatchConfig {
+    size_t max_messages = 100;
+    size_t max_bytes = 1024 * 1024;
+    std::chrono::milliseconds max_delay{10};
+};
+
+class PublishBatcher {
+  public:
+    using Batch = std::vector<PubSubMessage>;
+    using FlushFn = std::function<void(Batch&&)>;
+
+    /**
+     * @param config  Flush thresholds
+     * @param flush   Called with each completed batch; must not block for long
+     */
+    PublishBatcher(const BatchConfig& config, FlushFn flush);
+    ~PublishBatcher();
+
+    PublishBatcher(const PublishBatcher&) = delete;
+    PublishBatcher& operator=(const PublishBatcher&) = delete;
+
+    /**
+     * Add one message to the current batch
+     */
+    void add(PubSubMessage message);
+
+    /**
+     * Flush anything pending and stop the deadline thread
+     */
+    void shutdown();
+
+    const BatchConfig& config() const {
+        return config_;
+    }
+
+  private:
+    void timerLoop();
+    Batch takeLocked();
+
+    const BatchConfig config_;
+    const FlushFn flush_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    Batch pending_;
+    size_t pending_bytes_ = 0;
+    std::chrono::steady_clock::time_point deadline_;
+    bool stopping_ = false;
+
+    std::thread timer_;
+};
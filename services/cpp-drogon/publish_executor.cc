@@ -0,0 +1,235 @@
+/**
+ * Fixed-size worker pool for background Pub/Sub publishing.
+ */
+
+#include "publish_executor.h"
+
+#include <utility>
+
+bool parseOverflowPolicy(const std::string& name, OverflowPolicy& policy) {
+    if (name == "drop-oldest") {
+        policy = OverflowPolicy::DropOldest;
+    } else if (name == "drop-new") {
+        policy = OverflowPolicy::DropNew;
+    } else if (name == "block") {
+        policy = OverflowPolicy::Block;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* overflowPolicyName(OverflowPolicy policy) {
+    switch (policy) {
+        case OverflowPolicy::DropOldest:
+            return "drop-oldest";
+        case OverflowPolicy::DropNew:
+            return "drop-new";
+        case OverflowPolicy::Block:
+            return "block";
+    }
+    return "unknown";
+}
+
+PublishExecutor::PublishExecutor(size_t workers, size_t queue_depth, OverflowPolicy policy,
+                                 OverloadConfig overload)
+    : queue_depth_(queue_depth > 0 ? queue_depth : 1),
+      policy_(policy),
+      overload_(overload),
+      overload_depth_(queue_depth_ - queue_depth_ / 4) {
+    if (workers == 0) {
+        workers = 1;
+    }
+    workers_.reserve(workers);
+    running_ = workers;
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.emplace_back([this]() {
+            workerLoop();
+            std::lock_guard<std::mutex> lock(mutex_);
+            --running_;
+            exited_.notify_all();
+        });
+    }
+}
+
+PublishExecutor::~PublishExecutor() {
+    shutdown();
+}
+
+bool PublishExecutor::submit(Task task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopping_) {
+        ++dropped_;
+        return false;
+    }
+
+    bool accepted = true;
+    Task evicted;  // Destroyed after the lock is released
+    if (queue_.size() >= queue_depth_) {
+        switch (policy_) {
+            case OverflowPolicy::DropOldest:
+                evicted = std::move(queue_.front().task);
+                queue_.pop_front();
+                ++dropped_;
+                accepted = false;
+                break;
+            case OverflowPolicy::DropNew:
+                ++dropped_;
+                return false;
+            case OverflowPolicy::Block:
+                not_full_.wait(lock,
+                               [this]() { return stopping_ || queue_.size() < queue_depth_; });
+                if (stopping_) {
+                    ++dropped_;
+                    return false;
+                }
+                break;
+        }
+    }
+
+    queue_.push_back({std::move(task), Clock::now()});
+    if (overload_.target.count() > 0 && queue_.size() >= overload_depth_) {
+        overloaded_.store(true, std::memory_order_relaxed);
+    }
+    lock.unlock();
+    not_empty_.notify_one();
+    return accepted;
+}
+
+void PublishExecutor::shutdown() {
+    shutdown(Clock::time_point::max());
+}
+
+bool PublishExecutor::shutdown(Clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopping_ && workers_.empty()) {
+        return true;
+    }
+    stopping_ = true;
+    deadline_ = deadline;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+
+    auto exited = [this]() { return running_ == 0; };
+    if (deadline == Clock::time_point::max()) {
+        exited_.wait(lock, exited);
+    } else if (!exited_.wait_until(lock, deadline, exited)) {
+        // A task is stuck past the deadline; leave its worker behind
+        for (auto& worker : workers_) {
+            worker.detach();
+        }
+        workers_.clear();
+        return false;
+    }
+    lock.unlock();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    return true;
+}
+
+size_t PublishExecutor::depth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+uint64_t PublishExecutor::dropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+void PublishExecutor::workerLoop() {
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                // Stopping and fully drained
+                return;
+            }
+            if (stopping_ && Clock::now() >= deadline_) {
+                // Out of time: drop the rest, releasing tasks outside the lock
+                dropped_ += queue_.size();
+                std::deque<Entry> discarded;
+                discarded.swap(queue_);
+                lock.unlock();
+                return;
+            }
+            task = std::move(queue_.front().task);
+            updateOverloadLocked(queue_.front().enqueued);
+            queue_.pop_front();
+        }
+        not_full_.notify_one();
+        task();
+    }
+}
+
+void PublishExecutor::updateOverloadLocked(Clock::time_point enqueued) {
+    if (overload_.target.count() == 0) {
+        return;
+    }
+    // queue_ still holds the task being taken
+    if (queue_.size() > overload_depth_) {
+        overloaded_.store(true, std::memory_order_relaxed);
+        return;
+    }
+    auto now = Clock::now();
+    if (now - enqueued < overload_.target || queue_.size() == 1) {
+        // Short wait or nothing left behind it: no standing queue
+        first_above_ = Clock::time_point();
+        overloaded_.store(false, std::memory_order_relaxed);
+    } else if (first_above_ == Clock::time_point()) {
+        first_above_ = now + overload_.interval;
+    } else if (now >= first_above_) {
+        overloaded_.store(true, std::memory_order_relaxed);
+    }
+}
+
+InFlightLimit::InFlightLimit(size_t limit) : limit_(limit > 0 ? limit : 1) {}
+
+bool InFlightLimit::acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Re-checked on every change, so a deadline set meanwhile is picked up
+    while (in_flight_ >= limit_) {
+        if (deadline_ == Clock::time_point::max()) {
+            changed_.wait(lock);
+        } else if (changed_.wait_until(lock, deadline_) == std::cv_status::timeout) {
+            return false;
+        }
+    }
+    if (Clock::now() >= deadline_) {
+        return false;
+    }
+    ++in_flight_;
+    return true;
+}
+
+void InFlightLimit::setDeadline(Clock::time_point deadline) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        deadline_ = deadline;
+    }
+    changed_.notify_all();
+}
+
+void InFlightLimit::release() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --in_flight_;
+    }
+    // Both a blocked acquire and waitIdle may be waiting
+    changed_.notify_all();
+}
+
+bool InFlightLimit::waitIdle(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return changed_.wait_for(lock, timeout, [this]() { return in_flight_ == 0; });
+}
+
+size_t InFlightLimit::inFlight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_flight_;
+}
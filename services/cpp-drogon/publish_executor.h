@@ -0,0 +1,176 @@
+/**
+ * Fixed-size worker pool for background Pub/Sub publishing.
+ *
+ * Replaces the thread-per-request model: IO loops submit tasks into a
+ * bounded queue and a fixed number of workers drain it. When the queue is
+ * full the configured overflow policy decides what happens to the task.
+ *
+ * The executor also tracks how long tasks wait in the queue and reports
+ * overload CoDel-style: once every task dequeued for a whole interval has
+ * waited longer than the target, it stays overloaded until one waits less
+ * or the queue drains. A nearly full queue counts as overloaded at once.
+ *
+ * With an asynchronous transport the workers only dispatch requests, and
+ * InFlightLimit caps how many may await a response. A worker waits for a
+ * free slot, so a slow Pub/Sub still shows up as queue delay.
+ *
+ * Both can be given a deadline at shutdown; threads still busy when it
+ * passes are left running rather than waited for.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * What to do with a new task when the queue is at capacity
+ */
+enum class OverflowPolicy {
+    DropOldest,  // Evict the oldest queued task to make room
+    DropNew,     // Reject the incoming task
+    Block,       // Block the submitter until space is available
+};
+
+/**
+ * Parse an overflow policy name ("drop-oldest", "drop-new", "block").
+ * Returns false if the name is not recognised. The server refuses to start
+ * with "block", since it submits from the IO loops.
+ */
+bool parseOverflowPolicy(const std::string& name, OverflowPolicy& policy);
+
+/**
+ * Get the canonical name of an overflow policy
+ */
+const char* overflowPolicyName(OverflowPolicy policy);
+
+/**
+ * Queue-delay overload detection; a zero target disables it
+ */
+struct OverloadConfig {
+    std::chrono::milliseconds target{100};
+    std::chrono::milliseconds interval{1000};
+};
+
+class PublishExecutor {
+  public:
+    using Task = std::function<void()>;
+
+    PublishExecutor(size_t workers, size_t queue_depth, OverflowPolicy policy,
+                    OverloadConfig overload = {});
+    ~PublishExecutor();
+
+    PublishExecutor(const PublishExecutor&) = delete;
+    PublishExecutor& operator=(const PublishExecutor&) = delete;
+
+    /**
+     * Queue a task for execution on a worker thread.
+     * Returns false if the task (or, for DropOldest, another task) was dropped.
+     */
+    bool submit(Task task);
+
+    /**
+     * Stop accepting tasks, run everything already queued, and join workers
+     */
+    void shutdown();
+
+    /**
+     * Same, but tasks still queued at the deadline are discarded (and
+     * counted as dropped). A task already running is not interrupted: if
+     * one is still running at the deadline, its worker is detached and this
+     * returns false. The executor must then outlive that worker.
+     */
+    bool shutdown(std::chrono::steady_clock::time_point deadline);
+
+    size_t depth() const;
+    uint64_t dropped() const;
+
+    /**
+     * Lock-free; safe to poll on every request
+     */
+    bool overloaded() const {
+        return overloaded_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        Task task;
+        Clock::time_point enqueued;
+    };
+
+    void workerLoop();
+    void updateOverloadLocked(Clock::time_point enqueued);
+
+    const size_t queue_depth_;
+    const OverflowPolicy policy_;
+    const OverloadConfig overload_;
+    const size_t overload_depth_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::condition_variable exited_;
+    std::deque<Entry> queue_;
+    uint64_t dropped_ = 0;
+    size_t running_ = 0;  // Workers that have not returned from workerLoop()
+    bool stopping_ = false;
+    Clock::time_point deadline_ = Clock::time_point::max();
+    Clock::time_point first_above_{};  // Zero while waits are under target
+    std::atomic<bool> overloaded_{false};
+
+    std::vector<std::thread> workers_;
+};
+
+/**
+ * Counting limit on publishes awaiting a response
+ */
+class InFlightLimit {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit InFlightLimit(size_t limit);
+
+    InFlightLimit(const InFlightLimit&) = delete;
+    InFlightLimit& operator=(const InFlightLimit&) = delete;
+
+    /**
+     * Take a slot, blocking while all are in use. Returns false, without a
+     * slot, once the deadline set by setDeadline() has passed.
+     */
+    bool acquire();
+
+    /**
+     * Make acquire() give up at deadline, including calls already waiting
+     */
+    void setDeadline(Clock::time_point deadline);
+
+    /**
+     * Return a slot; never blocks, so completions can call it on an event loop
+     */
+    void release();
+
+    /**
+     * Wait until nothing is in flight. Returns false on timeout.
+     */
+    bool waitIdle(std::chrono::milliseconds timeout);
+
+    size_t inFlight() const;
+
+  private:
+    const size_t limit_;
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    size_t in_flight_ = 0;
+    Clock::time_point deadline_ = Clock::time_point::max();
+};
@@ -0,0 +1,370 @@
+/**
+ * Spill-to-disk outbox for publishes that failed with a transient error.
+ */
+
+#include "publish_outbox.h"
+
+#include <trantor/utils/Logger.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <random>
+#include <sodium.h>
+#include <string_view>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+// Segment layout: a fixed header, then records appended back to back.
+// Record: u32 payload length, checksum, payload. Payload: u32 data length,
+// data, u32 attribute count, then (u32 length, key, u32 length, value) pairs.
+struct PublishOutbox::Header {
+    char magic[8];
+    uint64_t write_offset;
+    uint64_t ack_offset;
+};
+
+namespace {
+
+constexpr char MAGIC[8] = {'D', 'B', 'O', 'X', 'S', 'E', 'G', '1'};
+constexpr size_t HEADER_SIZE = 64;
+constexpr size_t CHECKSUM_BYTES = crypto_generichash_BYTES_MIN;
+constexpr size_t RECORD_OVERHEAD = sizeof(uint32_t) + CHECKSUM_BYTES;
+constexpr size_t MIN_CAPACITY = 64 * 1024;
+
+void putU32(unsigned char*& out, uint32_t value) {
+    std::memcpy(out, &value, sizeof(value));
+    out += sizeof(value);
+}
+
+uint32_t getU32(const unsigned char*& in) {
+    uint32_t value;
+    std::memcpy(&value, in, sizeof(value));
+    in += sizeof(value);
+    return value;
+}
+
+void putBytes(unsigned char*& out, std::string_view bytes) {
+    putU32(out, static_cast<uint32_t>(bytes.size()));
+    std::memcpy(out, bytes.data(), bytes.size());
+    out += bytes.size();
+}
+
+std::string_view getBytes(const unsigned char*& in) {
+    uint32_t size = getU32(in);
+    std::string_view bytes(reinterpret_cast<const char*>(in), size);
+    in += size;
+    return bytes;
+}
+
+size_t payloadSize(const PubSubMessage& message) {
+    size_t size = 2 * sizeof(uint32_t) + message.data.size();
+    for (const auto& [key, value] : message.attributes) {
+        size += 2 * sizeof(uint32_t) + key.size() + value.size();
+    }
+    return size;
+}
+
+void checksum(const unsigned char* payload, size_t size, unsigned char* out) {
+    crypto_generichash(out, CHECKSUM_BYTES, payload, size, nullptr, 0);
+}
+
+}  // namespace
+
+PublishOutbox::PublishOutbox(size_t max_batch, PublishFn publish)
+    : max_batch_(max_batch > 0 ? max_batch : 1), publish_(std::move(publish)) {}
+
+PublishOutbox::~PublishOutbox() {
+    shutdown();
+}
+
+bool PublishOutbox::open(const std::string& path, size_t capacity, std::string& error) {
+    capacity = std::max(capacity, MIN_CAPACITY);
+
+    int fd = -1;
+    void* mapped = MAP_FAILED;
+    if (path.empty()) {
+        mapped =
+            mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    } else {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            error = std::strerror(errno);
+            return false;
+        }
+        // One process per segment; a second instance would replay the same records
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            error = "in use by another process";
+            ::close(fd);
+            return false;
+        }
+        struct stat st {};
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) > capacity) {
+            // Never shrink a segment that may still hold records
+            capacity = static_cast<size_t>(st.st_size);
+        }
+        if (ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+            error = std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        mapped = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (mapped == MAP_FAILED) {
+        error = std::strerror(errno);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    fd_ = fd;
+    base_ = static_cast<unsigned char*>(mapped);
+    capacity_ = capacity;
+    header_ = reinterpret_cast<Header*>(base_);
+
+    static_assert(sizeof(Header) <= HEADER_SIZE, "header does not fit");
+    if (std::memcmp(header_->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header_->ack_offset < HEADER_SIZE || header_->ack_offset > header_->write_offset ||
+        header_->write_offset > capacity_) {
+        std::memcpy(header_->magic, MAGIC, sizeof(MAGIC));
+        header_->write_offset = HEADER_SIZE;
+        header_->ack_offset = HEADER_SIZE;
+    }
+    pending_messages_ = validateLocked();
+
+    retry_running_ = true;
+    retry_ = std::thread([this]() {
+        retryLoop();
+        std::lock_guard<std::mutex> lock(mutex_);
+        retry_running_ = false;
+        acked_.notify_all();
+    });
+    return true;
+}
+
+size_t PublishOutbox::append(const Batch& batch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!header_ || stopping_) {
+        dropped_ += batch.size();
+        return 0;
+    }
+
+    size_t appended = 0;
+    for (const auto& message : batch) {
+        size_t payload = payloadSize(message);
+        size_t record = RECORD_OVERHEAD + payload;
+        if (header_->write_offset + record > capacity_ && header_->ack_offset > HEADER_SIZE) {
+            // Reclaim acknowledged space at the front
+            size_t live = header_->write_offset - header_->ack_offset;
+            std::memmove(base_ + HEADER_SIZE, base_ + header_->ack_offset, live);
+            header_->ack_offset = HEADER_SIZE;
+            header_->write_offset = HEADER_SIZE + live;
+        }
+        if (header_->write_offset + record > capacity_) {
+            break;
+        }
+
+        unsigned char* out = base_ + header_->write_offset;
+        putU32(out, static_cast<uint32_t>(payload));
+        unsigned char* sum = out;
+        out += CHECKSUM_BYTES;
+        unsigned char* body = out;
+        putBytes(out, message.data);
+        putU32(out, static_cast<uint32_t>(message.attributes.size()));
+        for (const auto& [key, value] : message.attributes) {
+            putBytes(out, key);
+            putBytes(out, value);
+        }
+        checksum(body, payload, sum);
+
+        // Publish the record only once it is complete
+        header_->write_offset += record;
+        ++appended;
+    }
+
+    pending_messages_ += appended;
+    dropped_ += batch.size() - appended;
+    if (appended > 0) {
+        cv_.notify_one();
+    }
+    return appended;
+}
+
+size_t PublishOutbox::drain(std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!header_ || stopping_) {
+        return pending_messages_;
+    }
+    draining_ = true;
+    cv_.notify_all();
+    acked_.wait_until(lock, deadline, [this]() { return pending_messages_ == 0; });
+    return pending_messages_;
+}
+
+void PublishOutbox::shutdown() {
+    shutdown(std::chrono::steady_clock::time_point::max());
+}
+
+bool PublishOutbox::shutdown(std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopping_) {
+        return true;
+    }
+    stopping_ = true;
+    cv_.notify_all();
+
+    auto exited = [this]() { return !retry_running_; };
+    if (deadline == std::chrono::steady_clock::time_point::max()) {
+        acked_.wait(lock, exited);
+    } else if (!acked_.wait_until(lock, deadline, exited)) {
+        // A publish is stuck past the deadline; it still reads the mapping
+        retry_.detach();
+        return false;
+    }
+    lock.unlock();
+    if (retry_.joinable()) {
+        retry_.join();
+    }
+
+    lock.lock();
+    if (base_) {
+        if (fd_ >= 0) {
+            msync(base_, capacity_, MS_SYNC);
+        }
+        munmap(base_, capacity_);
+        base_ = nullptr;
+        header_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    return true;
+}
+
+size_t PublishOutbox::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_messages_;
+}
+
+uint64_t PublishOutbox::dropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+void PublishOutbox::retryLoop() {
+    std::minstd_rand rng(std::random_device{}());
+    auto backoff = MIN_BACKOFF;
+    bool failing = false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        cv_.wait(lock, [this]() {
+            return stopping_ || header_->ack_offset < header_->write_offset;
+        });
+        if (stopping_) {
+            return;
+        }
+        if (failing) {
+            // Full jitter: spread retries from many instances across the window.
+            // A drain cuts a long wait short and keeps the rest at the minimum.
+            bool draining = draining_;
+            auto cap = draining ? MIN_BACKOFF : backoff;
+            std::uniform_int_distribution<long long> jitter(0, cap.count());
+            auto delay = std::chrono::milliseconds(jitter(rng));
+            cv_.wait_for(lock, delay, [this, draining]() {
+                return stopping_ || draining_ != draining;
+            });
+            if (stopping_) {
+                return;
+            }
+        }
+
+        Batch batch;
+        size_t bytes = readBatchLocked(batch);
+        lock.unlock();
+        PublishOutcome outcome = publish_(batch);
+        lock.lock();
+
+        if (outcome.ok || !outcome.retryable) {
+            if (!outcome.ok) {
+                dropped_ += batch.size();
+                LOG_ERROR << "Pub/Sub outbox dropped " << batch.size()
+                          << " message(s) after a permanent error: " << outcome.error;
+            } else if (failing) {
+                LOG_INFO << "Pub/Sub outbox delivering again";
+            }
+            pending_messages_ -= batch.size();
+            ackLocked(bytes);
+            acked_.notify_all();
+            failing = false;
+            backoff = MIN_BACKOFF;
+        } else {
+            if (!failing) {
+                LOG_WARN << "Pub/Sub outbox retry failed (" << pending_messages_
+                         << " message(s) waiting): " << outcome.error;
+            }
+            failing = true;
+            backoff = std::min(backoff * 2, MAX_BACKOFF);
+        }
+    }
+}
+
+size_t PublishOutbox::readBatchLocked(Batch& batch) const {
+    size_t offset = header_->ack_offset;
+    while (batch.size() < max_batch_ && offset < header_->write_offset) {
+        const unsigned char* in = base_ + offset;
+        uint32_t payload = getU32(in);
+        in += CHECKSUM_BYTES;
+
+        std::string_view data = getBytes(in);
+        PubSubMessage message(data.size());
+        message.data.assign(data);
+        uint32_t attributes = getU32(in);
+        for (uint32_t i = 0; i < attributes; ++i) {
+            std::string_view key = getBytes(in);
+            std::string_view value = getBytes(in);
+            message.attributes.emplace_back(key, value);
+        }
+        batch.push_back(std::move(message));
+        offset += RECORD_OVERHEAD + payload;
+    }
+    return offset - header_->ack_offset;
+}
+
+void PublishOutbox::ackLocked(size_t bytes) {
+    header_->ack_offset += bytes;
+    if (header_->ack_offset == header_->write_offset) {
+        header_->ack_offset = HEADER_SIZE;
+        header_->write_offset = HEADER_SIZE;
+    }
+}
+
+size_t PublishOutbox::validateLocked() {
+    size_t offset = header_->ack_offset;
+    size_t records = 0;
+    unsigned char sum[CHECKSUM_BYTES];
+    while (offset + RECORD_OVERHEAD <= header_->write_offset) {
+        const unsigned char* in = base_ + offset;
+        uint32_t payload = getU32(in);
+        if (payload < 2 * sizeof(uint32_t) ||
+            offset + RECORD_OVERHEAD + payload > header_->write_offset) {
+            break;
+        }
+        checksum(in + CHECKSUM_BYTES, payload, sum);
+        if (std::memcmp(sum, in, CHECKSUM_BYTES) != 0) {
+            break;
+        }
+        offset += RECORD_OVERHEAD + payload;
+        ++records;
+    }
+    // Drop a torn or corrupt tail
+    header_->write_offset = offset;
+    return records;
+}
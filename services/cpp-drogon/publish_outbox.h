@@ -0,0 +1,110 @@
+/**
+ * Spill-to-disk outbox for publishes that failed with a transient error.
+ *
+ * Failed batches are appended as checksummed records to one fixed-size,
+ * memory-mapped segment file and retried from a single background thread
+ * with capped exponential backoff and full jitter, oldest first. The file
+ * is the only storage, so memory stays constant however long Pub/Sub is
+ * down; once it is full, new batches are dropped and counted. Records that
+ * are still unacknowledged at exit are replayed by the next process that
+ * opens the same file. With an empty path the segment is an anonymous
+ * mapping: same behaviour, without the replay.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pubsub_transport.h"
+
+class PublishOutbox {
+  public:
+    using Batch = std::vector<PubSubMessage>;
+    using PublishFn = std::function<PublishOutcome(const Batch&)>;
+
+    // Retry delay bounds; each attempt waits a random time up to the current cap
+    static constexpr std::chrono::milliseconds MIN_BACKOFF{100};
+    static constexpr std::chrono::milliseconds MAX_BACKOFF{30000};
+
+    /**
+     * @param max_batch  Most messages sent per retry
+     * @param publish    Synchronous publish, called from the retry thread
+     */
+    PublishOutbox(size_t max_batch, PublishFn publish);
+    ~PublishOutbox();
+
+    PublishOutbox(const PublishOutbox&) = delete;
+    PublishOutbox& operator=(const PublishOutbox&) = delete;
+
+    /**
+     * Map the segment and start retrying anything it already holds.
+     * On failure returns false and sets error to a short description.
+     */
+    bool open(const std::string& path, size_t capacity, std::string& error);
+
+    /**
+     * Store a failed batch for retry. Returns how many messages were stored:
+     * a prefix of the batch, all of it unless the segment is full.
+     */
+    size_t append(const Batch& batch);
+
+    /**
+     * Retry at the minimum backoff until nothing is pending or the deadline
+     * passes. Returns the messages still pending; call shutdown() after.
+     */
+    size_t drain(std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * Stop retrying; unsent records stay in the file for the next start
+     */
+    void shutdown();
+
+    /**
+     * Same, but if a retry is still running at the deadline its thread is
+     * detached, the segment stays mapped, and this returns false. The
+     * outbox must then outlive that thread.
+     */
+    bool shutdown(std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * Messages currently waiting for retry
+     */
+    size_t pending() const;
+
+    uint64_t dropped() const;
+
+  private:
+    struct Header;
+
+    void retryLoop();
+    size_t readBatchLocked(Batch& batch) const;
+    void ackLocked(size_t bytes);
+    size_t validateLocked();
+
+    const size_t max_batch_;
+    const PublishFn publish_;
+
+    int fd_ = -1;
+    unsigned char* base_ = nullptr;
+    size_t capacity_ = 0;
+    Header* header_ = nullptr;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable acked_;
+    size_t pending_messages_ = 0;
+    uint64_t dropped_ = 0;
+    bool draining_ = false;
+    bool stopping_ = false;
+    bool retry_running_ = false;
+
+    std::thread retry_;
+};
@@ -0,0 +1,71 @@
+/**
+ * OAuth access tokens for production Pub/Sub.
+ */
+
+#include "pubsub_auth.h"
+
+#include <drogon/drogon.h>
+
+#include <sstream>
+
+using namespace drogon;
+
+namespace {
+
+constexpr const char* METADATA_HOST = "http://metadata.google.internal";
+constexpr const char* METADATA_TOKEN_PATH =
+    "/computeMetadata/v1/instance/service-accounts/default/token";
+
+// Refresh this long before the reported expiry
+constexpr std::chrono::seconds TOKEN_REFRESH_MARGIN{60};
+
+}  // namespace
+
+MetadataTokenProvider::MetadataTokenProvider() {
+    // Not app().getLoop(): that loop only runs once app().run() has been called
+    loop_thread_.run();
+    client_ = HttpClient::newHttpClient(METADATA_HOST, loop_thread_.getLoop());
+}
+
+std::string MetadataTokenProvider::token(double timeout) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+    std::unique_lock<std::timed_mutex> lock(mutex_, std::defer_lock);
+    if (timeout <= 0 || !lock.try_lock_until(deadline)) {
+        return "";
+    }
+    if (token_.empty() || std::chrono::steady_clock::now() >= expires_at_) {
+        std::chrono::duration<double> left = deadline - std::chrono::steady_clock::now();
+        if (left.count() <= 0 || !refreshLocked(left.count())) {
+            return "";
+        }
+    }
+    return token_;
+}
+
+bool MetadataTokenProvider::refreshLocked(double timeout) {
+    auto req = HttpRequest::newHttpRequest();
+    req->setMethod(Get);
+    req->setPath(METADATA_TOKEN_PATH);
+    req->addHeader("Metadata-Flavor", "Google");
+
+    auto [result, resp] = client_->sendRequest(req, timeout);
+    if (result != ReqResult::Ok || !resp || resp->getStatusCode() != k200OK) {
+        LOG_ERROR << "Failed to fetch access token from metadata server";
+        return false;
+    }
+
+    Json::Value json;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    std::istringstream stream{std::string(resp->body())};
+    if (!Json::parseFromStream(builder, stream, &json, &errors) || !json.isObject() ||
+        !json["access_token"].isString()) {
+        LOG_ERROR << "Invalid access token response from metadata server";
+        return false;
+    }
+
+    auto lifetime = std::chrono::seconds(json.get("expires_in", 0).asInt64());
+    token_ = json["access_token"].asString();
+    expires_at_ = std::chrono::steady_clock::now() + lifetime - TOKEN_REFRESH_MARGIN;
+    return true;
+}
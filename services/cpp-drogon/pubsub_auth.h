@@ -0,0 +1,47 @@
+/**
+ * OAuth access tokens for production Pub/Sub.
+ *
+ * On Cloud Run the service account token comes from the metadata server.
+ * Tokens are cached and only refreshed shortly before they expire, so the
+ * metadata server is hit roughly once an hour rather than per publish.
+ * The client runs on a loop of its own, so token() also works before
+ * app().run() (eager Pub/Sub start) and from any thread.
+ */
+
+#pragma once
+
+#include <drogon/HttpClient.h>
+#include <trantor/net/EventLoopThread.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+class MetadataTokenProvider {
+  public:
+    MetadataTokenProvider();
+
+    MetadataTokenProvider(const MetadataTokenProvider&) = delete;
+    MetadataTokenProvider& operator=(const MetadataTokenProvider&) = delete;
+
+    // Longest a fetch may take, including the wait for another caller's fetch
+    static constexpr double FETCH_TIMEOUT = 5.0;
+
+    /**
+     * Get a valid access token, fetching a new one if the cached token is
+     * missing or about to expire. Returns an empty string on failure or if
+     * no token is available within timeout seconds. Blocks the caller while
+     * fetching; call from a publish worker only.
+     */
+    std::string token(double timeout = FETCH_TIMEOUT);
+
+  private:
+    bool refreshLocked(double timeout);
+
+    trantor::EventLoopThread loop_thread_{"MetadataLoop"};  // Outlives client_
+    drogon::HttpClientPtr client_;
+
+    std::timed_mutex mutex_;
+    std::string token_;
+    std::chrono::steady_clock::time_point expires_at_;
+};
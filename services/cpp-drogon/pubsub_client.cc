@@ -0,0 +1,39 @@
+/**
+ * Long-lived HTTP client pool for the Pub/Sub REST API.
+ */
+
+#include "pubsub_client.h"
+
+PubSubClientPool::PubSubClientPool(const std::string& base_url, size_t size, size_t loops,
+                                   size_t pipelining) {
+    if (size == 0) {
+        size = 1;
+    }
+    if (loops == 0 || loops > size) {
+        loops = size;
+    }
+
+    loops_ = std::make_unique<trantor::EventLoopThreadPool>(loops, "PubSubLoop");
+    loops_->start();
+
+    clients_.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        auto client = drogon::HttpClient::newHttpClient(base_url, loops_->getNextLoop());
+        if (pipelining > 0) {
+            client->setPipeliningDepth(pipelining);
+        }
+        clients_.push_back(std::move(client));
+    }
+}
+
+const drogon::HttpClientPtr& PubSubClientPool::acquire() {
+    size_t index = next_.fetch_add(1, std::memory_order_relaxed);
+    return clients_[index % clients_.size()];
+}
+
+void PubSubClientPool::stop() {
+    for (trantor::EventLoop* loop : loops_->getLoops()) {
+        loop->quit();
+    }
+    loops_->wait();
+}
@@ -0,0 +1,53 @@
+/**
+ * Long-lived HTTP client pool for the Pub/Sub REST API.
+ *
+ * Clients are created once at startup and keep their connections alive, so
+ * each publish reuses a warm socket instead of paying a TCP connect. The
+ * clients are spread across a small set of dedicated event loops so that
+ * publish I/O never runs on the request-serving IO loops.
+ */
+
+#pragma once
+
+#include <drogon/HttpClient.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <trantor/net/EventLoopThreadPool.h>
+#include <vector>
+
+class PubSubClientPool {
+  public:
+    /**
+     * @param base_url    Pub/Sub endpoint, e.g. "http://localhost:8085"
+     * @param size        Number of persistent clients (one connection each)
+     * @param loops       Number of event loops the clients are spread across
+     * @param pipelining  HTTP/1.1 pipelining depth per connection (0 = off)
+     */
+    PubSubClientPool(const std::string& base_url, size_t size, size_t loops, size_t pipelining);
+
+    PubSubClientPool(const PubSubClientPool&) = delete;
+    PubSubClientPool& operator=(const PubSubClientPool&) = delete;
+
+    /**
+     * Pick the next client in round-robin order (lock-free)
+     */
+    const drogon::HttpClientPtr& acquire();
+
+    size_t size() const {
+        return clients_.size();
+    }
+
+    /**
+     * Quit the client loops and join their threads. Callbacks of requests
+     * still in flight never run; the clients must not be used afterwards.
+     */
+    void stop();
+
+  private:
+    std::unique_ptr<trantor::EventLoopThreadPool> loops_;
+    std::vector<drogon::HttpClientPtr> clients_;
+    std::atomic<size_t> next_{0};
+};
@@ -0,0 +1,102 @@
+/**
+ * Pub/Sub gRPC transport.
+ */
+
+#include "pubsub_grpc.h"
+
+#include <chrono>
+#include <utility>
+
+namespace {
+
+// Keep the channel warm between bursts so a publish never waits on a reconnect
+constexpr int KEEPALIVE_TIME_MS = 30000;
+constexpr int KEEPALIVE_TIMEOUT_MS = 10000;
+
+// Upper bound on how long warmUp() waits for the channel to connect
+constexpr std::chrono::seconds CONNECT_TIMEOUT{5};
+
+// Seconds allowed for one Publish call, including the token fetch
+constexpr double PUBLISH_TIMEOUT = 5.0;
+
+}  // namespace
+
+GrpcPubSubTransport::GrpcPubSubTransport(const std::string& endpoint,
+                                         const std::string& topic_path,
+                                         std::shared_ptr<MetadataTokenProvider> tokens)
+    : topic_path_(topic_path), tokens_(std::move(tokens)) {
+    grpc::ChannelArguments args;
+    args.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS, KEEPALIVE_TIME_MS);
+    args.SetInt(GRPC_ARG_KEEPALIVE_TIMEOUT_MS, KEEPALIVE_TIMEOUT_MS);
+    args.SetInt(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+
+    auto credentials = tokens_ ? grpc::SslCredentials(grpc::SslCredentialsOptions())
+                               : grpc::InsecureChannelCredentials();
+    channel_ = grpc::CreateCustomChannel(endpoint, credentials, args);
+    stub_ = google::pubsub::v1::Publisher::NewStub(channel_);
+}
+
+PublishOutcome GrpcPubSubTransport::publish(const std::vector<PubSubMessage>& batch) {
+    PublishOutcome outcome;
+
+    google::pubsub::v1::PublishRequest request;
+    request.set_topic(topic_path_);
+    for (const auto& message : batch) {
+        auto* entry = request.add_messages();
+        entry->set_data(message.data.data(), message.data.size());
+        auto& attributes = *entry->mutable_attributes();
+        for (const auto& [key, value] : message.attributes) {
+            attributes[std::string(key)].assign(value.data(), value.size());
+        }
+    }
+
+    double timeout = callTimeout(PUBLISH_TIMEOUT);
+    if (timeout <= 0) {
+        outcome.error = "drain deadline passed";
+        outcome.retryable = true;
+        return outcome;
+    }
+    auto deadline = std::chrono::system_clock::now() +
+                    std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                        std::chrono::duration<double>(timeout));
+    grpc::ClientContext context;
+    context.set_deadline(deadline);
+    if (tokens_) {
+        std::string token = tokens_->token(timeout);
+        if (token.empty()) {
+            outcome.error = "no access token";
+            outcome.retryable = true;
+            return outcome;
+        }
+        context.AddMetadata("authorization", "Bearer " + token);
+    }
+
+    google::pubsub::v1::PublishResponse response;
+    grpc::Status status = stub_->Publish(&context, request, &response);
+
+    outcome.code = status.error_code();
+    outcome.ok = status.ok();
+    if (!outcome.ok) {
+        outcome.error = status.error_message();
+        switch (status.error_code()) {
+            case grpc::StatusCode::UNAVAILABLE:
+            case grpc::StatusCode::DEADLINE_EXCEEDED:
+            case grpc::StatusCode::RESOURCE_EXHAUSTED:
+            case grpc::StatusCode::ABORTED:
+            case grpc::StatusCode::INTERNAL:
+                outcome.retryable = true;
+                break;
+            default:
+                break;
+        }
+    }
+    return outcome;
+}
+
+void GrpcPubSubTransport::warmUp() {
+    if (tokens_) {
+        tokens_->token();
+    }
+    // Resolve, connect and finish the TLS handshake now rather than on the first publish
+    channel_->WaitForConnected(std::chrono::system_clock::now() + CONNECT_TIMEOUT);
+}
@@ -0,0 +1,183 @@
+/**
+ * Pub/Sub REST/JSON transport.
+ */
+
+#include "pubsub_rest.h"
+
+#include <drogon/drogon.h>
+
+#include <utility>
+
+#include "codec.h"
+
+using namespace drogon;
+
+namespace {
+
+// Seconds to wait for a publish response, including time queued on the connection
+constexpr double PUBLISH_TIMEOUT = 5.0;
+
+PublishOutcome responseOutcome(ReqResult result, const HttpResponsePtr& resp) {
+    PublishOutcome outcome;
+    if (result != ReqResult::Ok || !resp) {
+        outcome.error = result == ReqResult::Timeout ? "timeout" : "connection error";
+        outcome.retryable = true;
+        return outcome;
+    }
+
+    outcome.code = resp->getStatusCode();
+    outcome.ok = outcome.code == k200OK;
+    if (!outcome.ok) {
+        outcome.error = std::string(resp->body());
+        outcome.retryable = outcome.code == k429TooManyRequests || outcome.code >= 500;
+    }
+    return outcome;
+}
+
+PublishOutcome deadlineOutcome() {
+    PublishOutcome outcome;
+    outcome.error = "drain deadline passed";
+    outcome.retryable = true;
+    return outcome;
+}
+
+}  // namespace
+
+RestPubSubTransport::RestPubSubTransport(std::unique_ptr<PubSubClientPool> clients,
+                                         const std::string& topic_path,
+                                         std::shared_ptr<MetadataTokenProvider> tokens)
+    : clients_(std::move(clients)),
+      publish_path_("/v1/" + topic_path + ":publish"),
+      tokens_(std::move(tokens)) {}
+
+std::string buildPublishBody(const std::vector<PubSubMessage>& batch) {
+    // {"messages":[{"data":"<base64>","attributes":{"k":"v",...}},...]}
+    // Reserved up front; only escapes in attribute strings can outgrow it
+    size_t size = sizeof(R"({"messages":[]})");
+    for (const auto& message : batch) {
+        size += sizeof(R"({"data":""},)") + base64EncodedSize(message.data.size());
+        if (!message.attributes.empty()) {
+            size += sizeof(R"(,"attributes":{})");
+            for (const auto& [key, value] : message.attributes) {
+                size += key.size() + value.size() + sizeof(R"("":"",)");
+            }
+        }
+    }
+
+    std::string body;
+    body.reserve(size);
+    body += R"({"messages":[)";
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const PubSubMessage& message = batch[i];
+        if (i > 0) {
+            body += ',';
+        }
+        // Base64 goes straight into the body, no intermediate string
+        body += R"({"data":")";
+        size_t at = body.size();
+        body.resize(at + base64EncodedSize(message.data.size()));
+        base64EncodeTo(reinterpret_cast<const unsigned char*>(message.data.data()),
+                       message.data.size(), body.data() + at);
+        body += '"';
+
+        if (!message.attributes.empty()) {
+            body += R"(,"attributes":{)";
+            bool first = true;
+            for (const auto& [key, value] : message.attributes) {
+                if (!first) {
+                    body += ',';
+                }
+                first = false;
+                body += '"';
+                appendJsonEscaped(body, key);
+                body += R"(":")";
+                appendJsonEscaped(body, value);
+                body += '"';
+            }
+            body += '}';
+        }
+        body += '}';
+    }
+    body += "]}";
+    return body;
+}
+
+HttpRequestPtr RestPubSubTransport::buildRequest(const std::vector<PubSubMessage>& batch,
+                                                 double timeout, PublishOutcome& outcome) {
+    auto req = HttpRequest::newHttpRequest();
+    req->setMethod(Post);
+    req->setPath(publish_path_);
+    req->setContentTypeCode(CT_APPLICATION_JSON);
+    req->setBody(buildPublishBody(batch));
+
+    if (tokens_) {
+        std::string token = tokens_->token(timeout);
+        if (token.empty()) {
+            outcome.error = "no access token";
+            outcome.retryable = true;
+            return nullptr;
+        }
+        req->addHeader("Authorization", "Bearer " + token);
+    }
+    return req;
+}
+
+PublishOutcome RestPubSubTransport::publish(const std::vector<PubSubMessage>& batch) {
+    double timeout = callTimeout(PUBLISH_TIMEOUT);
+    if (timeout <= 0) {
+        return deadlineOutcome();
+    }
+    PublishOutcome outcome;
+    auto req = buildRequest(batch, timeout, outcome);
+    if (!req) {
+        return outcome;
+    }
+
+    // Send synchronously (we're already in a background thread); the token
+    // fetch may have used part of the time
+    timeout = callTimeout(PUBLISH_TIMEOUT);
+    if (timeout <= 0) {
+        return deadlineOutcome();
+    }
+    auto [result, resp] = clients_->acquire()->sendRequest(req, timeout);
+    return responseOutcome(result, resp);
+}
+
+void RestPubSubTransport::publishAsync(const std::vector<PubSubMessage>& batch,
+                                       PublishCallback done) {
+    double timeout = callTimeout(PUBLISH_TIMEOUT);
+    if (timeout <= 0) {
+        done(deadlineOutcome());
+        return;
+    }
+    PublishOutcome outcome;
+    auto req = buildRequest(batch, timeout, outcome);
+    if (!req) {
+        done(std::move(outcome));
+        return;
+    }
+
+    // The client's loop owns the timeout; done runs there either way
+    timeout = callTimeout(PUBLISH_TIMEOUT);
+    if (timeout <= 0) {
+        done(deadlineOutcome());
+        return;
+    }
+    clients_->acquire()->sendRequest(
+        req,
+        [done = std::move(done)](ReqResult result, const HttpResponsePtr& resp) {
+            done(responseOutcome(result, resp));
+        },
+        timeout);
+}
+
+void RestPubSubTransport::warmUp() {
+    // Connections are opened by the first publish; the token fetch is the slow part
+    if (tokens_) {
+        tokens_->token();
+    }
+}
+
+void RestPubSubTransport::shutdown() {
+    clients_->stop();
+}
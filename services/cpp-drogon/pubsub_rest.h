@@ -0,0 +1,64 @@
+/**
+ * Pub/Sub REST/JSON transport.
+ *
+ * Sends batches to {base}/v1/projects/{project}/topics/{topic}:publish over
+ * the persistent client pool. The request body is written in one pass, with
+ * payloads base64-encoded straight into it as the JSON API requires. An
+ * access token is attached when talking to production Pub/Sub.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pubsub_auth.h"
+#include "pubsub_client.h"
+#include "pubsub_transport.h"
+
+/**
+ * Serialize a batch as a topics.publish request body
+ */
+std::string buildPublishBody(const std::vector<PubSubMessage>& batch);
+
+class RestPubSubTransport : public PubSubTransport {
+  public:
+    /**
+     * @param clients     Persistent HTTP clients for the endpoint
+     * @param topic_path  "projects/{project}/topics/{topic}"
+     * @param tokens      Access token source, or nullptr for the emulator
+     */
+    RestPubSubTransport(std::unique_ptr<PubSubClientPool> clients, const std::string& topic_path,
+                        std::shared_ptr<MetadataTokenProvider> tokens);
+
+    PublishOutcome publish(const std::vector<PubSubMessage>& batch) override;
+
+    /**
+     * Hands the request to the client's event loop; done runs there with the outcome
+     */
+    void publishAsync(const std::vector<PubSubMessage>& batch, PublishCallback done) override;
+
+    void warmUp() override;
+
+    /**
+     * Stops the client loops; requests still awaiting a response are abandoned
+     */
+    void shutdown() override;
+
+    const char* name() const override {
+        return "rest";
+    }
+
+  private:
+    /**
+     * Build the publish request, or return nullptr with outcome set on
+     * failure. timeout bounds the access token fetch.
+     */
+    drogon::HttpRequestPtr buildRequest(const std::vector<PubSubMessage>& batch, double timeout,
+                                        PublishOutcome& outcome);
+
+    std::unique_ptr<PubSubClientPool> clients_;
+    const std::string publish_path_;
+    std::shared_ptr<MetadataTokenProvider> tokens_;
+};
@@ -0,0 +1,143 @@
+/**
+ * Pub/Sub message model and the transport interface used by the publish workers.
+ *
+ * A transport sends one batch of messages to the configured topic. Messages
+ * carry the raw payload bytes; encoding for the wire (base64 for REST, raw
+ * bytes for gRPC) is the transport's job.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "message_arena.h"
+
+/**
+ * A message owns an arena that backs its payload, its attribute list and
+ * every attribute string. The arena is a recycled block from the building
+ * thread's pool (see message_arena.h), so a message costs no allocation per
+ * string and, in steady state, none at all; the block goes back to its pool
+ * in one go once the batch holding the message has been settled.
+ */
+struct PubSubMessage {
+    using String = std::pmr::string;
+    using Attribute = std::pair<String, String>;
+
+    // Arena space on top of the payload for up to MAX_ATTRIBUTES attributes
+    static constexpr size_t ATTRIBUTE_ARENA_SIZE = 1024;
+    static constexpr size_t MAX_ATTRIBUTES = 8;
+
+    explicit PubSubMessage(size_t payload_size = 0)
+        : arena(MessageArena::acquire(payload_size + ATTRIBUTE_ARENA_SIZE)),
+          data(arena->resource()),
+          attributes(arena->resource()) {
+        attributes.reserve(MAX_ATTRIBUTES);
+    }
+
+    PubSubMessage(PubSubMessage&&) noexcept = default;
+    // Containers stay bound to the arena they were built in, so messages
+    // can be moved into place but not move-assigned over one another
+    PubSubMessage& operator=(PubSubMessage&&) = delete;
+
+    /**
+     * Approximate payload size, used for batch byte limits
+     */
+    size_t byteSize() const {
+        size_t size = data.size();
+        for (const auto& [key, value] : attributes) {
+            size += key.size() + value.size();
+        }
+        return size;
+    }
+
+    // Declared first so it outlives the containers allocating from it
+    MessageArenaPtr arena;
+    String data;
+    std::pmr::vector<Attribute> attributes;
+};
+
+/**
+ * Result of a publish call.
+ * code is the HTTP status (REST), the gRPC status code (gRPC), or 0 when no
+ * response was received at all.
+ */
+struct PublishOutcome {
+    bool ok = false;
+    int code = 0;
+    std::string error;
+    // Failure is transient (no response, throttling, server error) and worth retrying
+    bool retryable = false;
+};
+
+class PubSubTransport {
+  public:
+    using PublishCallback = std::function<void(PublishOutcome)>;
+
+    virtual ~PubSubTransport() = default;
+
+    /**
+     * Publish a batch synchronously; called from a publish worker thread
+     */
+    virtual PublishOutcome publish(const std::vector<PubSubMessage>& batch) = 0;
+
+    /**
+     * Start a publish and return without waiting for the response. done is
+     * called exactly once with the outcome, possibly on a transport thread,
+     * and must not block. batch only has to stay alive until this returns.
+     * The default publishes synchronously on the calling thread.
+     */
+    virtual void publishAsync(const std::vector<PubSubMessage>& batch, PublishCallback done) {
+        done(publish(batch));
+    }
+
+    /**
+     * Fetch credentials and open connections ahead of the first publish.
+     * Called once from the startup thread; may block.
+     */
+    virtual void warmUp() {}
+
+    /**
+     * Stop the transport's own threads. No publishAsync callback runs after
+     * this returns; call it once nothing publishes any more.
+     */
+    virtual void shutdown() {}
+
+    /**
+     * Short name for logs ("rest" or "grpc")
+     */
+    virtual const char* name() const = 0;
+
+    /**
+     * Cut every publish (and token fetch) started from now on short at
+     * deadline; the drain uses this so no call outlives PUBSUB_DRAIN_MS
+     */
+    void setDeadline(std::chrono::steady_clock::time_point deadline) {
+        deadline_.store(deadline, std::memory_order_relaxed);
+    }
+
+  protected:
+    /**
+     * Seconds a call may take: timeout, or less if the deadline is nearer.
+     * Zero or negative once the deadline has passed.
+     */
+    double callTimeout(double timeout) const {
+        auto deadline = deadline_.load(std::memory_order_relaxed);
+        if (deadline == std::chrono::steady_clock::time_point::max()) {
+            return timeout;
+        }
+        std::chrono::duration<double> left = deadline - std::chrono::steady_clock::now();
+        return std::min(timeout, left.count());
+    }
+
+  private:
+    std::atomic<std::chrono::steady_clock::time_point> deadline_{
+        std::chrono::steady_clock::time_point::max()};
+};
@@ -0,0 +1,67 @@
+/**
+ * Ed25519 verification engine for Discord request signatures.
+ *
+ * The public key is decoded and validated once at startup and kept in fixed
+ * storage, so a malformed or small-order key fails at boot instead of on
+ * every request. Verification itself is libsodium's
+ * crypto_sign_verify_detached, which keeps rejection semantics identical to
+ * the reference implementation.
+ *
+ * Requests that verified are remembered per thread by a BLAKE2b digest,
+ * keyed with the public key, of signature, timestamp and body. Only a
+ * byte-identical repeat (a Discord retry or a probe) matches, and only
+ * while its timestamp is still fresh, so it skips the Ed25519 check
+ * without accepting anything the check would reject.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <sodium.h>
+#include <string>
+#include <string_view>
+
+class SignatureVerifier {
+  public:
+    // Oldest accepted X-Signature-Timestamp, in seconds behind the wall clock
+    static constexpr int64_t MAX_TIMESTAMP_AGE = 5;
+
+    // Verified requests remembered per thread (direct-mapped)
+    static constexpr size_t VERDICT_CACHE_ENTRIES = 64;
+
+    /**
+     * Decode and validate a hex-encoded public key.
+     * On failure returns false and sets error to a short description.
+     */
+    bool setPublicKey(const std::string& hex, std::string& error);
+
+    bool ready() const {
+        return ready_;
+    }
+
+    /**
+     * Reuse verdicts for repeated requests (on by default)
+     */
+    void setVerdictCache(bool enabled) {
+        cache_verdicts_ = enabled;
+    }
+
+    /**
+     * Verify a detached signature over timestamp + body
+     */
+    bool verify(const unsigned char* signature, std::string_view timestamp,
+                std::string_view body) const;
+
+    /**
+     * Check a request's headers as sent: hex signature, fresh epoch timestamp
+     */
+    bool verifyRequest(std::string_view signature_hex, std::string_view timestamp,
+                       std::string_view body) const;
+
+  private:
+    std::array<unsigned char, crypto_sign_PUBLICKEYBYTES> key_{};
+    bool ready_ = false;
+    bool cache_verdicts_ = true;
+};
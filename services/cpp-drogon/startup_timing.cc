@@ -0,0 +1,103 @@
+/**
+ * Startup phase instrumentation.
+ */
+
+#include "startup_timing.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+
+#include "async_log.h"
+
+namespace {
+
+constexpr std::array<const char*, STARTUP_PHASE_COUNT> PHASE_NAMES = {
+    "main", "sodium_init", "config", "subsystems", "routes", "listen", "first_connection",
+    "first_response",
+};
+
+// Microseconds since boot per phase; 0 means not yet recorded
+std::array<std::atomic<int64_t>, STARTUP_PHASE_COUNT> g_phases{};
+std::atomic<bool> g_reported{false};
+
+int64_t bootTimeMicros() {
+    timespec ts{};
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * Process start time in microseconds since boot (clock-tick resolution),
+ * from field 22 of /proc/self/stat. Returns 0 if unavailable.
+ */
+int64_t processStartMicros() {
+    std::ifstream file("/proc/self/stat");
+    std::string stat;
+    if (!std::getline(file, stat)) {
+        return 0;
+    }
+    // The command name (field 2) may contain spaces; fields resume after its ')'
+    size_t pos = stat.rfind(')');
+    if (pos == std::string::npos) {
+        return 0;
+    }
+    std::istringstream fields(stat.substr(pos + 1));
+    std::string field;
+    for (int i = 3; i < 22; ++i) {
+        if (!(fields >> field)) {
+            return 0;
+        }
+    }
+    unsigned long long ticks = 0;
+    long ticks_per_second = sysconf(_SC_CLK_TCK);
+    if (!(fields >> ticks) || ticks_per_second <= 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(ticks * 1000000 / ticks_per_second);
+}
+
+void reportStartup() {
+    int64_t origin = processStartMicros();
+    const char* origin_name = "exec";
+    if (origin == 0) {
+        origin = g_phases[static_cast<size_t>(StartupPhase::Main)].load();
+        origin_name = "main";
+    }
+
+    std::ostringstream line;
+    line << R"({"severity":"INFO","message":"startup timing","origin":")" << origin_name
+         << R"(","phases_us":{)";
+    bool first = true;
+    for (size_t i = 0; i < STARTUP_PHASE_COUNT; ++i) {
+        int64_t at = g_phases[i].load();
+        if (at == 0) {
+            continue;
+        }
+        line << (first ? "" : ",") << '"' << PHASE_NAMES[i] << "\":" << at - origin;
+        first = false;
+    }
+    line << "}}";
+    // Through the log sink when there is one, which owns stdout
+    logStructured(line.str());
+}
+
+}  // namespace
+
+void markStartupPhase(StartupPhase phase) {
+    // Cheap relaxed check first: hot-path hooks keep calling this after startup
+    auto& slot = g_phases[static_cast<size_t>(phase)];
+    int64_t expected = 0;
+    if (slot.load(std::memory_order_relaxed) != 0 ||
+        !slot.compare_exchange_strong(expected, bootTimeMicros())) {
+        return;
+    }
+    if (phase == StartupPhase::FirstResponse && !g_reported.exchange(true)) {
+        reportStartup();
+    }
+}
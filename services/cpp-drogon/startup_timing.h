@@ -0,0 +1,32 @@
+/**
+ * Startup phase instrumentation.
+ *
+ * Each phase is stamped once with CLOCK_BOOTTIME, the clock the kernel uses
+ * for a process's start time, so the offsets include exec and dynamic
+ * loading before main(). When the first response has been sent, all phases
+ * are reported as one structured log entry whose "phases_us" object holds
+ * microsecond offsets from exec (or from main() when the process start time
+ * is unavailable), so Cloud Logging indexes each phase as a field.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+enum class StartupPhase {
+    Main,             // main() entered
+    SodiumInit,       // libsodium initialized
+    Config,           // Environment read and public key prepared
+    Subsystems,       // Pub/Sub and other optional subsystems created
+    Routes,           // Handlers and advices registered
+    Listen,           // Event loop running with the listener bound
+    FirstConnection,  // First TCP connection accepted
+    FirstResponse,    // First HTTP response handed to the connection
+};
+constexpr size_t STARTUP_PHASE_COUNT = 8;
+
+/**
+ * Record a phase; only the first call per phase counts. Thread-safe.
+ * Marking FirstResponse emits the startup report.
+ */
+void markStartupPhase(StartupPhase phase);
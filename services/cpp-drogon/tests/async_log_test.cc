@@ -0,0 +1,147 @@
+/**
+ * Tests for log secret redaction and the asynchronous JSON log sink.
+ */
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "async_log.h"
+
+namespace {
+
+std::string redacted(std::string text) {
+    redactSecrets(text);
+    return text;
+}
+
+/**
+ * Runs a sink over a pipe and hands back everything it wrote, one JSON
+ * object per line
+ */
+class SinkCapture {
+  public:
+    SinkCapture() {
+        EXPECT_EQ(pipe2(fds_, O_CLOEXEC), 0);
+        fcntl(fds_[0], F_SETFL, O_NONBLOCK);
+        sink_ = std::make_unique<AsyncLogSink>(fds_[1]);
+    }
+
+    ~SinkCapture() {
+        sink_.reset();
+        close(fds_[0]);
+        close(fds_[1]);
+    }
+
+    AsyncLogSink& sink() {
+        return *sink_;
+    }
+
+    std::vector<Json::Value> drain() {
+        sink_->shutdown();
+        std::string output;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = read(fds_[0], buffer, sizeof(buffer))) > 0) {
+            output.append(buffer, static_cast<size_t>(n));
+        }
+        std::vector<Json::Value> entries;
+        std::istringstream lines(output);
+        std::string line;
+        while (std::getline(lines, line)) {
+            Json::Value entry;
+            std::string errors;
+            std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+            EXPECT_TRUE(reader->parse(line.data(), line.data() + line.size(), &entry, &errors))
+                << line;
+            entries.push_back(entry);
+        }
+        return entries;
+    }
+
+  private:
+    int fds_[2] = {-1, -1};
+    std::unique_ptr<AsyncLogSink> sink_;
+};
+
+}  // namespace
+
+TEST(RedactSecretsTest, RedactsJsonTokenValues) {
+    EXPECT_EQ(redacted(R"({"id":"1","token":"SECRET","type":2})"),
+              R"({"id":"1","token":"[REDACTED]","type":2})");
+    EXPECT_EQ(redacted(R"({"token" : "SE\"CR\\ET", "id":"1"})"),
+              R"({"token" : "[REDACTED]", "id":"1"})");
+    EXPECT_EQ(redacted(R"({"Token":"SECRET"})"), R"({"Token":"[REDACTED]"})");
+}
+
+TEST(RedactSecretsTest, RedactsHeadersAndQueryValues) {
+    EXPECT_EQ(redacted("X-Signature-Ed25519: abcdef0123"), "X-Signature-Ed25519: [REDACTED]");
+    EXPECT_EQ(redacted("x-signature-timestamp=1700000000;next"),
+              "x-signature-timestamp=[REDACTED];next");
+    EXPECT_EQ(redacted("token=SECRET&type=2"), "token=[REDACTED]&type=2");
+    EXPECT_EQ(redacted("Authorization: Bearer ya29.SECRET more"),
+              "Authorization: Bearer [REDACTED] more");
+    EXPECT_EQ(redacted("a token=ONE and token=TWO"), "a token=[REDACTED] and token=[REDACTED]");
+}
+
+TEST(RedactSecretsTest, LeavesProseAndEmptyValuesAlone) {
+    for (const char* text : {"no access token available", "tokens are rotated", "token=",
+                             "token:", "", "signature check failed"}) {
+        EXPECT_EQ(redacted(text), text);
+    }
+}
+
+TEST(RedactSecretsTest, HandlesUnterminatedValues) {
+    EXPECT_EQ(redacted(R"("token":"SECRET)"), R"("token":"[REDACTED])");
+    EXPECT_EQ(redacted(R"("token":"SECRET\)"), R"("token":"[REDACTED])");
+    EXPECT_EQ(redacted("token=SECRET"), "token=[REDACTED]");
+}
+
+TEST(AsyncLogSinkTest, WritesRedactedJsonLines) {
+    SinkCapture capture;
+    const std::string line =
+        "20261014 12:00:00.000000 UTC 4242 WARN body {\"token\":\"SECRET\"} - main.cc:10\n";
+    ASSERT_TRUE(capture.sink().push(line.data(), line.size()));
+    const std::string object = R"({"severity":"INFO","message":"m","token":"SECRET","n":1})";
+    ASSERT_TRUE(capture.sink().pushJson(object.data(), object.size()));
+
+    std::vector<Json::Value> entries = capture.drain();
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0]["severity"].asString(), "WARNING");
+    EXPECT_EQ(entries[0]["message"].asString(),
+              "body {\"token\":\"[REDACTED]\"} - main.cc:10");
+    EXPECT_EQ(entries[1]["token"].asString(), "[REDACTED]");
+    EXPECT_EQ(entries[1]["n"].asInt(), 1);
+}
+
+TEST(AsyncLogSinkTest, TruncatesLongLinesOnACharacterBoundary) {
+    SinkCapture capture;
+    std::string line = "x";
+    while (line.size() < 2 * AsyncLogSink::SLOT_BYTES) {
+        line += "\xC3\xA9";
+    }
+    ASSERT_TRUE(capture.sink().push(line.data(), line.size()));
+
+    std::vector<Json::Value> entries = capture.drain();
+    ASSERT_EQ(entries.size(), 1u);
+    std::string message = entries[0]["message"].asString();
+    EXPECT_EQ(message.size(), AsyncLogSink::SLOT_BYTES - 1);
+    EXPECT_EQ(message, line.substr(0, message.size()));
+}
+
+TEST(AsyncLogSinkTest, RejectsOversizedObjects) {
+    SinkCapture capture;
+    std::string object = R"({"message":")" + std::string(AsyncLogSink::SLOT_BYTES, 'x') + "\"}";
+    EXPECT_FALSE(capture.sink().pushJson(object.data(), object.size()));
+    EXPECT_EQ(capture.sink().dropped(), 1u);
+
+    // The writer reports the drop as its own entry
+    std::vector<Json::Value> entries = capture.drain();
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0]["severity"].asString(), "WARNING");
+}
@@ -0,0 +1,128 @@
+/**
+ * Tests for the hex/base64 codecs and the JSON string escaper.
+ */
+
+#include <array>
+#include <gtest/gtest.h>
+#include <random>
+#include <sodium.h>
+#include <string>
+#include <vector>
+
+#include "codec.h"
+
+namespace {
+
+std::string sodiumBase64(std::string_view input) {
+    std::string out(sodium_base64_encoded_len(input.size(), sodium_base64_VARIANT_ORIGINAL), '\0');
+    sodium_bin2base64(out.data(), out.size(), reinterpret_cast<const unsigned char*>(input.data()),
+                      input.size(), sodium_base64_VARIANT_ORIGINAL);
+    out.pop_back();  // Trailing NUL
+    return out;
+}
+
+std::string escaped(std::string_view text) {
+    std::string out;
+    appendJsonEscaped(out, text);
+    return out;
+}
+
+}  // namespace
+
+TEST(Base64Test, Rfc4648Vectors) {
+    EXPECT_EQ(base64Encode(""), "");
+    EXPECT_EQ(base64Encode("f"), "Zg==");
+    EXPECT_EQ(base64Encode("fo"), "Zm8=");
+    EXPECT_EQ(base64Encode("foo"), "Zm9v");
+    EXPECT_EQ(base64Encode("foob"), "Zm9vYg==");
+    EXPECT_EQ(base64Encode("fooba"), "Zm9vYmE=");
+    EXPECT_EQ(base64Encode("foobar"), "Zm9vYmFy");
+}
+
+TEST(Base64Test, MatchesLibsodiumForEveryByteAndLength) {
+    std::string input;
+    for (int i = 0; i < 256; ++i) {
+        input += static_cast<char>(255 - i);
+    }
+    for (size_t n = 0; n <= input.size(); ++n) {
+        std::string_view prefix(input.data(), n);
+        ASSERT_EQ(base64Encode(prefix), sodiumBase64(prefix)) << "length " << n;
+    }
+}
+
+TEST(Base64Test, EncodeToWritesExactlyEncodedSize) {
+    const std::string input = "hello";
+    std::string out(base64EncodedSize(input.size()) + 1, '#');
+    base64EncodeTo(reinterpret_cast<const unsigned char*>(input.data()), input.size(),
+                   out.data());
+    EXPECT_EQ(out, "aGVsbG8=#");
+}
+
+TEST(HexDecodeTest, DecodesEitherCase) {
+    std::array<unsigned char, 4> out{};
+    ASSERT_TRUE(hexDecode("00fFa9Be", out.data(), out.size()));
+    EXPECT_EQ(out, (std::array<unsigned char, 4>{0x00, 0xFF, 0xA9, 0xBE}));
+}
+
+TEST(HexDecodeTest, RejectsWrongLength) {
+    std::array<unsigned char, 4> out{};
+    EXPECT_FALSE(hexDecode("00ff", out.data(), out.size()));
+    EXPECT_FALSE(hexDecode("00ffa9b", out.data(), out.size()));
+    EXPECT_FALSE(hexDecode("00ffa9be0", out.data(), out.size()));
+    EXPECT_TRUE(hexDecode("", out.data(), 0));
+}
+
+TEST(HexDecodeTest, RejectsNonHexAtEveryPosition) {
+    // 64 characters: four 16-character SIMD blocks; 70 adds a scalar tail
+    const char bad[] = {'/', ':', '@', 'G', '`', 'g', ' ', '\0', '\x80', '\xC1', '\xFF'};
+    for (size_t length : {64u, 70u}) {
+        std::vector<unsigned char> out(length / 2);
+        for (size_t pos = 0; pos < length; ++pos) {
+            for (char c : bad) {
+                std::string hex(length, 'a');
+                hex[pos] = c;
+                ASSERT_FALSE(hexDecode(hex, out.data(), out.size()))
+                    << "length " << length << " position " << pos << " char " << int(c);
+            }
+        }
+    }
+}
+
+TEST(HexDecodeTest, MatchesLibsodiumOnRandomInput) {
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> byte(0, 255);
+    const std::string digits = "0123456789abcdefABCDEF";
+    for (int round = 0; round < 2000; ++round) {
+        size_t size = static_cast<size_t>(round % 40);
+        std::string hex(2 * size, '0');
+        for (char& c : hex) {
+            c = digits[static_cast<size_t>(byte(rng)) % digits.size()];
+        }
+        std::vector<unsigned char> out(size), want(size);
+        ASSERT_TRUE(hexDecode(hex, out.data(), size));
+        size_t decoded = 0;
+        ASSERT_EQ(sodium_hex2bin(want.data(), size, hex.data(), hex.size(), nullptr, &decoded,
+                                 nullptr),
+                  0);
+        ASSERT_EQ(decoded, size);
+        ASSERT_EQ(out, want) << hex;
+    }
+}
+
+TEST(JsonEscapeTest, EscapesQuotesBackslashesAndControls) {
+    EXPECT_EQ(escaped(R"(say "hi" \ bye)"), R"(say \"hi\" \\ bye)");
+    EXPECT_EQ(escaped("a\nb\tc"), R"(a\nb\tc)");
+    EXPECT_EQ(escaped(std::string("\x01\x1f\x00", 3)), R"(\u0001\u001f\u0000)");
+    EXPECT_EQ(escaped("\r\b\f"), R"(\u000d\u0008\u000c)");
+}
+
+TEST(JsonEscapeTest, PassesPrintableAndUtf8Through) {
+    EXPECT_EQ(escaped("plain / text \x7f"), "plain / text \x7f");
+    EXPECT_EQ(escaped("caf\xC3\xA9 \xF0\x9F\x98\x80"), "caf\xC3\xA9 \xF0\x9F\x98\x80");
+}
+
+TEST(JsonEscapeTest, Appends) {
+    std::string out = "{\"k\":\"";
+    appendJsonEscaped(out, "v\"");
+    EXPECT_EQ(out, R"({"k":"v\")");
+}
@@ -0,0 +1,115 @@
+/**
+ * Tests for the interaction id cache: duplicates, forget with
+ * backward-shift deletion, capacity eviction and the TTL.
+ */
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+#include <sodium.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "idempotency_cache.h"
+
+namespace {
+
+class IdempotencyCacheTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        ASSERT_GE(sodium_init(), 0);
+    }
+};
+
+std::string interactionId(int n) {
+    return "1" + std::to_string(1000000000000000LL + n);
+}
+
+}  // namespace
+
+TEST_F(IdempotencyCacheTest, ReportsDuplicatesWithinTheTtl) {
+    IdempotencyCache cache(1024, std::chrono::seconds(60));
+    EXPECT_FALSE(cache.checkAndReserve("1234567890"));
+    EXPECT_TRUE(cache.checkAndReserve("1234567890"));
+    EXPECT_TRUE(cache.checkAndReserve("1234567890"));
+    EXPECT_FALSE(cache.checkAndReserve("1234567891"));
+}
+
+TEST_F(IdempotencyCacheTest, ForgetReleasesTheReservation) {
+    IdempotencyCache cache(1024, std::chrono::seconds(60));
+    EXPECT_FALSE(cache.checkAndReserve("dropped"));
+    cache.forget("dropped");
+    cache.forget("dropped");
+    cache.forget("never-seen");
+    EXPECT_FALSE(cache.checkAndReserve("dropped"));
+    EXPECT_TRUE(cache.checkAndReserve("dropped"));
+}
+
+TEST_F(IdempotencyCacheTest, ForgetKeepsEveryOtherIdFindable) {
+    // Random forgets shift later probe-run members back into the hole; ids
+    // sharing a run must stay findable and forgotten ones must be gone.
+    // Far below capacity, so nothing is evicted for space.
+    std::mt19937 rng(7);
+    for (int round = 0; round < 20; ++round) {
+        IdempotencyCache cache(64 * 64, std::chrono::seconds(60));
+        std::vector<std::string> ids;
+        for (int i = 0; i < 384; ++i) {
+            ids.push_back(interactionId(round * 1000 + i));
+            ASSERT_FALSE(cache.checkAndReserve(ids.back()));
+        }
+        std::set<std::string> forgotten;
+        for (const std::string& id : ids) {
+            if (rng() % 2 == 0) {
+                cache.forget(id);
+                forgotten.insert(id);
+            }
+        }
+        for (const std::string& id : ids) {
+            bool was_forgotten = forgotten.count(id) != 0;
+            // Re-reserves forgotten ids, so check the survivors first
+            if (!was_forgotten) {
+                ASSERT_TRUE(cache.checkAndReserve(id)) << "round " << round << " lost " << id;
+            }
+        }
+        for (const std::string& id : forgotten) {
+            ASSERT_FALSE(cache.checkAndReserve(id)) << "round " << round << " kept " << id;
+        }
+    }
+}
+
+TEST_F(IdempotencyCacheTest, EvictsTheOldestWhenAStripeIsFull) {
+    // One entry per stripe: any later id landing in the same stripe evicts
+    IdempotencyCache cache(IdempotencyCache::STRIPES, std::chrono::seconds(60));
+    EXPECT_FALSE(cache.checkAndReserve("first"));
+    for (int i = 0; i < 2000; ++i) {
+        cache.checkAndReserve(interactionId(i));
+    }
+    EXPECT_FALSE(cache.checkAndReserve("first"));
+}
+
+TEST_F(IdempotencyCacheTest, ForgetsIdsOnceTheTtlPasses) {
+    IdempotencyCache cache(1024, std::chrono::seconds(1));
+    EXPECT_FALSE(cache.checkAndReserve("expiring"));
+    EXPECT_TRUE(cache.checkAndReserve("expiring"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_FALSE(cache.checkAndReserve("expiring"));
+    EXPECT_TRUE(cache.checkAndReserve("expiring"));
+}
+
+TEST_F(IdempotencyCacheTest, ZeroTtlNeverSuppresses) {
+    IdempotencyCache cache(1024, std::chrono::seconds(0));
+    EXPECT_FALSE(cache.checkAndReserve("id"));
+    EXPECT_FALSE(cache.checkAndReserve("id"));
+}
+
+TEST_F(IdempotencyCacheTest, MemoryIsFixedAtConstruction) {
+    IdempotencyCache cache(10000, std::chrono::seconds(60));
+    size_t bytes = cache.memoryBytes();
+    EXPECT_GT(bytes, 0u);
+    for (int i = 0; i < 50000; ++i) {
+        cache.checkAndReserve(interactionId(i));
+    }
+    EXPECT_EQ(cache.memoryBytes(), bytes);
+}
@@ -0,0 +1,272 @@
+/**
+ * Tests for the interaction parser backends: the scan backend must accept,
+ * reject and publish exactly what the jsoncpp reference backend does.
+ */
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "interaction.h"
+
+namespace {
+
+struct Parsed {
+    ParseStatus status;
+    int type = -1;
+    std::string data;
+    std::vector<std::pair<std::string, std::string>> attributes;
+};
+
+Parsed parseWith(ParserBackend backend, std::string_view body) {
+    auto parser = createInteractionParser(backend);
+    Parsed parsed;
+    parsed.status = parser->parse(body, parsed.type);
+    if (parsed.status == ParseStatus::Ok && parsed.type == INTERACTION_TYPE_APPLICATION_COMMAND) {
+        PubSubMessage message = parser->buildMessage();
+        parsed.data.assign(message.data.data(), message.data.size());
+        for (const auto& [key, value] : message.attributes) {
+            parsed.attributes.emplace_back(std::string(key), std::string(value));
+        }
+    }
+    return parsed;
+}
+
+Json::Value parseJson(const std::string& text) {
+    Json::Value value;
+    std::string errors;
+    std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+    EXPECT_TRUE(reader->parse(text.data(), text.data() + text.size(), &value, &errors))
+        << errors << "\n"
+        << text;
+    return value;
+}
+
+/**
+ * Both backends give the same verdict, type, payload value and attributes
+ */
+void expectEquivalent(std::string_view body) {
+    SCOPED_TRACE(std::string(body));
+    Parsed scan = parseWith(ParserBackend::Scan, body);
+    Parsed jsoncpp = parseWith(ParserBackend::JsonCpp, body);
+    ASSERT_EQ(scan.status, jsoncpp.status);
+    if (scan.status != ParseStatus::Ok) {
+        return;
+    }
+    EXPECT_EQ(scan.type, jsoncpp.type);
+    if (scan.type == INTERACTION_TYPE_APPLICATION_COMMAND) {
+        EXPECT_EQ(parseJson(scan.data), parseJson(jsoncpp.data));
+        EXPECT_EQ(scan.attributes, jsoncpp.attributes);
+    }
+}
+
+const char* const SLASH_COMMAND = R"({
+    "type": 2,
+    "token": "SECRET_TOKEN",
+    "id": "1234567890",
+    "application_id": "9876543210",
+    "data": {"id": "cmd-1", "name": "report", "type": 1,
+             "options": [{"name": "text", "type": 3, "value": "caf\u00e9 \"q\" \\ \ud83d\ude00"}]},
+    "guild_id": "guild-1",
+    "channel_id": "channel-1",
+    "member": {"user": {"id": "user-1", "username": "tester"}, "roles": ["r1"], "nick": null},
+    "user": {"id": "user-1"},
+    "locale": "en-US",
+    "guild_locale": "de",
+    "app_permissions": "442368",
+    "version": 1
+})";
+
+}  // namespace
+
+TEST(InteractionParserTest, BackendsPublishTheSameSlashCommand) {
+    expectEquivalent(SLASH_COMMAND);
+
+    Parsed scan = parseWith(ParserBackend::Scan, SLASH_COMMAND);
+    Json::Value data = parseJson(scan.data);
+    EXPECT_FALSE(data.isMember("token"));
+    EXPECT_FALSE(data.isMember("app_permissions"));
+    EXPECT_EQ(data.size(), 10u);
+    EXPECT_EQ(data["data"]["options"][0]["value"].asString(),
+              "caf\xC3\xA9 \"q\" \\ \xF0\x9F\x98\x80");
+}
+
+TEST(InteractionParserTest, BackendsWriteRootFieldsInTheSameOrder) {
+    // Compact, ASCII, nested keys already sorted: jsoncpp's output is byte-identical
+    const char* body =
+        R"({"user":{"id":"u"},"type":2,"token":"t","member":{"nick":"n"},"locale":"en",)"
+        R"("id":"i","guild_locale":"de","guild_id":"g","data":{"name":"c"},)"
+        R"("channel_id":"ch","application_id":"a"})";
+    Parsed scan = parseWith(ParserBackend::Scan, body);
+    Parsed jsoncpp = parseWith(ParserBackend::JsonCpp, body);
+    ASSERT_EQ(scan.status, ParseStatus::Ok);
+    EXPECT_EQ(scan.data, jsoncpp.data);
+    EXPECT_EQ(scan.data,
+              R"({"application_id":"a","channel_id":"ch","data":{"name":"c"},"guild_id":"g",)"
+              R"("guild_locale":"de","id":"i","locale":"en","member":{"nick":"n"},"type":2,)"
+              R"("user":{"id":"u"}})");
+}
+
+TEST(InteractionParserTest, BackendsAgreeOnLenientInput) {
+    // jsoncpp's reader tolerates all of these; the scan backend defers to it
+    for (const char* body : {
+             "{\"type\":1} trailing",
+             "{\"type\":2,\"id\":\"x\"}{\"id\":\"y\"}",
+             "// comment\n{\"type\":1}",
+             "{\"type\":/* comment */2,\"data\":{/* c */\"name\":\"n\"}}",
+             "{\"type\":2,\"id\":01}",
+             "{\"type\":2,\"id\":1.}",
+             "{\"type\":2,\"id\":-}",
+             "{\"type\":2,\"id\":+1}",
+             "{\"type\":2,\"id\":[1,]}",
+             "{\"type\":2,}",
+             "{\"type\":2,\"id\":\"a\x01z\"}",
+             "\xEF\xBB\xBF{\"type\":1}",
+         }) {
+        expectEquivalent(body);
+        int type = 0;
+        EXPECT_EQ(createInteractionParser(ParserBackend::Scan)->parse(body, type), ParseStatus::Ok)
+            << body;
+    }
+}
+
+TEST(InteractionParserTest, BackendsAgreeOnRejectedInput) {
+    for (const char* body : {
+             "",
+             "[{\"type\":1}]",
+             "\"type\"",
+             "{not json}",
+             "{\"type\":2,\"id\":1e}",
+             "{\"type\":2,\"id\":.5}",
+             "{\"type\":2,\"id\":Infinity}",
+             "{\"type\":2,\"id\":'x'}",
+             "{\"type\":2 \"id\":1}",
+             "{\"type\":2,\"id\":tru}",
+             "{\"type\":2,\"id\":\"\\x\"}",
+             "{\"type\":2,\"id\":\"\\u12\"}",
+             // A high surrogate must be followed by another \u escape
+             "{\"type\":2,\"id\":\"\\ud800\"}",
+             "{\"type\":2,\"id\":\"\\ud800xxxxxx\"}",
+             // Numbers that overflow a double
+             "{\"type\":2,\"id\":1.8e308}",
+             "{\"type\":2,\"id\":-1e400}",
+             "{\"type\":2,\"id\":\"unterminated}",
+         }) {
+        expectEquivalent(body);
+        int type = 0;
+        EXPECT_EQ(createInteractionParser(ParserBackend::Scan)->parse(body, type),
+                  ParseStatus::InvalidJson)
+            << body;
+    }
+}
+
+TEST(InteractionParserTest, BackendsAgreeOnTypes) {
+    for (const char* body : {
+             "{\"type\":1}",
+             "{\"type\":2}",
+             "{\"type\":99}",
+             "{\"type\":2.0}",
+             "{\"type\":1e0}",
+             "{\"type\":-0.0}",
+             "{\"type\":2.5}",
+             "{\"type\":\"2\"}",
+             "{\"type\":true}",
+             "{\"type\":null}",
+             "{\"type\":3000000000}",
+             "{\"id\":\"no type\"}",
+             "{\"type\":1,\"type\":2}",
+             "{\"typ\\u0065\":2}",
+             "{\"type\":2,\"id\":1e-400,\"guild_id\":1e308}",
+             "{\"type\":2,\"id\":-0,\"guild_id\":2.50,\"channel_id\":18446744073709551616}",
+             "{\"type\":2,\"id\":-9223372036854775808,\"guild_id\":12345678901234567890}",
+         }) {
+        expectEquivalent(body);
+    }
+}
+
+TEST(InteractionParserTest, BackendsAgreeOnAttributeEdgeCases) {
+    for (const char* body : {
+             // Escapes, surrogate pairs, duplicates, escaped keys, non-string values
+             R"({"type":2,"id":"a\"b\\c\/d\n\u00e9\ud83d\ude00","data":{"name":"x","name":"y"}})",
+             R"({"type":2,"id":"\ud800\u0041","guild_id":null,"channel_id":true})",
+             R"({"type":2,"\u0069d":"escaped-key","data":{"n\u0061me":"escaped"}})",
+             R"({"type":2,"id":{"nested":1},"application_id":[1],"data":"not an object"})",
+             R"({"type":2,"\u0074oken":"escaped token key"})",
+         }) {
+        expectEquivalent(body);
+    }
+}
+
+TEST(InteractionParserTest, EscapedTokenKeyIsDropped) {
+    for (ParserBackend backend : {ParserBackend::Scan, ParserBackend::JsonCpp}) {
+        Parsed parsed = parseWith(backend, R"({"type":2,"\u0074oken":"SECRET","id":"1"})");
+        ASSERT_EQ(parsed.status, ParseStatus::Ok);
+        EXPECT_EQ(parsed.data.find("SECRET"), std::string::npos) << parsed.data;
+    }
+}
+
+TEST(InteractionParserTest, RecognisesPings) {
+    EXPECT_TRUE(isPingInteraction(R"({"type":1,"token":"t"})"));
+    EXPECT_TRUE(isPingInteraction(" {\"type\" : 1.0} "));
+    EXPECT_FALSE(isPingInteraction(R"({"type":2})"));
+    EXPECT_FALSE(isPingInteraction(R"({"type":1)"));
+    EXPECT_FALSE(isPingInteraction(R"([1])"));
+}
+
+TEST(InteractionParserTest, ParsesBackendNames) {
+    ParserBackend backend = ParserBackend::JsonCpp;
+    EXPECT_TRUE(parseParserBackend("scan", backend));
+    EXPECT_EQ(backend, ParserBackend::Scan);
+    EXPECT_TRUE(parseParserBackend("jsoncpp", backend));
+    EXPECT_EQ(backend, ParserBackend::JsonCpp);
+    EXPECT_FALSE(parseParserBackend("simdjson", backend));
+}
+
+TEST(SanitizeInteractionTest, KeepsExactlyTheAllowlistedFields) {
+    Json::Value interaction = parseJson(SLASH_COMMAND);
+    Json::Value sanitized = sanitizeInteraction(interaction);
+    EXPECT_EQ(sanitized.getMemberNames(),
+              (std::vector<std::string>{"application_id", "channel_id", "data", "guild_id",
+                                        "guild_locale", "id", "locale", "member", "type",
+                                        "user"}));
+    for (const std::string& name : sanitized.getMemberNames()) {
+        EXPECT_EQ(sanitized[name], interaction[name]) << name;
+    }
+}
+
+TEST(SanitizeInteractionTest, DropsNearMissKeys) {
+    // Prefixes, extensions, case changes and embedded NULs of allowlisted keys
+    Json::Value interaction(Json::objectValue);
+    for (const char* name : {"token", "i", "ids", "Type", "USER", "guild", "guild_id_",
+                             "data ", "", "member\x01", "app_permissions", "entitlements"}) {
+        interaction[name] = "x";
+    }
+    interaction[std::string("id\0x", 4)] = "nul";
+    interaction["type"] = 2;
+    Json::Value sanitized = sanitizeInteraction(interaction);
+    EXPECT_EQ(sanitized.getMemberNames(), (std::vector<std::string>{"type"}));
+}
+
+TEST(SanitizeInteractionTest, MoveOverloadMatchesCopy) {
+    Json::Value interaction = parseJson(SLASH_COMMAND);
+    Json::Value copied = sanitizeInteraction(interaction);
+    Json::Value moved = sanitizeInteraction(std::move(interaction));
+    EXPECT_EQ(moved, copied);
+    EXPECT_FALSE(moved.isMember("token"));
+}
+
+TEST(SanitizeInteractionTest, NonObjectGivesNull) {
+    for (const Json::Value& value :
+         {Json::Value(), Json::Value(2), Json::Value("token"), Json::Value(Json::arrayValue)}) {
+        EXPECT_TRUE(sanitizeInteraction(value).isNull()) << value;
+    }
+}
+
+TEST(SanitizeInteractionTest, ScanBackendDropsNearMissKeys) {
+    Parsed parsed = parseWith(ParserBackend::Scan,
+                              R"({"type":2,"tokens":"a","Token":"b","i":"c","ids":"d","id":"e"})");
+    ASSERT_EQ(parsed.status, ParseStatus::Ok);
+    EXPECT_EQ(parsed.data, R"({"id":"e","type":2})");
+}
@@ -0,0 +1,290 @@
+/**
+ * Tests for the spill-to-disk publish outbox: retry, replay after restart,
+ * torn-tail recovery and compaction of acknowledged space.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <functional>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "publish_outbox.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Matches the segment header in publish_outbox.cc: magic, write and ack offsets
+constexpr off_t WRITE_OFFSET_AT = 8;
+constexpr size_t HEADER_SIZE = 64;
+constexpr size_t MIN_CAPACITY = 64 * 1024;
+
+PubSubMessage makeMessage(const std::string& data) {
+    PubSubMessage message(data.size());
+    message.data.assign(data);
+    message.attributes.emplace_back("interaction_id", std::string_view(data).substr(0, 8));
+    return message;
+}
+
+PublishOutbox::Batch makeBatch(const std::vector<std::string>& data) {
+    PublishOutbox::Batch batch;
+    for (const std::string& item : data) {
+        batch.push_back(makeMessage(item));
+    }
+    return batch;
+}
+
+/**
+ * Publish function whose outcome the test controls. Fails retryably until
+ * allowed, then accepts up to budget messages; records what it accepted.
+ */
+class FakePublisher {
+  public:
+    PublishOutbox::PublishFn fn() {
+        return [this](const PublishOutbox::Batch& batch) {
+            PublishOutcome outcome;
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++calls_;
+            if (permanent_) {
+                outcome.error = "permanent";
+                return outcome;
+            }
+            if (budget_ < batch.size()) {
+                outcome.error = "unavailable";
+                outcome.retryable = true;
+                return outcome;
+            }
+            budget_ -= batch.size();
+            for (const auto& message : batch) {
+                published_.emplace_back(message.data.data(), message.data.size());
+                EXPECT_EQ(message.attributes.size(), 1u);
+                EXPECT_EQ(std::string_view(message.attributes[0].second),
+                          std::string_view(published_.back()).substr(0, 8));
+            }
+            outcome.ok = true;
+            return outcome;
+        };
+    }
+
+    void allow(size_t messages) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        budget_ = messages;
+    }
+
+    void failPermanently() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        permanent_ = true;
+    }
+
+    std::vector<std::string> published() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return published_;
+    }
+
+    int calls() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return calls_;
+    }
+
+  private:
+    std::mutex mutex_;
+    size_t budget_ = 0;
+    bool permanent_ = false;
+    int calls_ = 0;
+    std::vector<std::string> published_;
+};
+
+class PublishOutboxTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        char dir[] = "/tmp/outbox_test.XXXXXX";
+        ASSERT_NE(mkdtemp(dir), nullptr);
+        dir_ = dir;
+        path_ = dir_ + "/segment";
+    }
+
+    void TearDown() override {
+        unlink(path_.c_str());
+        rmdir(dir_.c_str());
+    }
+
+    void open(PublishOutbox& outbox) {
+        std::string error;
+        ASSERT_TRUE(outbox.open(path_, 0, error)) << error;
+    }
+
+    uint64_t readWriteOffset() {
+        uint64_t offset = 0;
+        int fd = ::open(path_.c_str(), O_RDONLY);
+        EXPECT_EQ(pread(fd, &offset, sizeof(offset), WRITE_OFFSET_AT), 8);
+        close(fd);
+        return offset;
+    }
+
+    void patch(off_t at, const void* bytes, size_t size) {
+        int fd = ::open(path_.c_str(), O_WRONLY);
+        EXPECT_EQ(pwrite(fd, bytes, size, at), static_cast<ssize_t>(size));
+        close(fd);
+    }
+
+    /**
+     * Leave three unsent records in the segment, as a process that exited
+     * during an outage would
+     */
+    void spillThree() {
+        FakePublisher down;
+        PublishOutbox outbox(10, down.fn());
+        open(outbox);
+        ASSERT_EQ(outbox.append(makeBatch({"record-1", "record-2", "record-3"})), 3u);
+        outbox.shutdown();
+    }
+
+    std::string dir_;
+    std::string path_;
+};
+
+bool waitFor(const std::function<bool()>& done) {
+    auto deadline = Clock::now() + std::chrono::seconds(10);
+    while (!done()) {
+        if (Clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+}  // namespace
+
+TEST_F(PublishOutboxTest, RetriesUntilPublished) {
+    FakePublisher publisher;
+    PublishOutbox outbox(10, publisher.fn());
+    open(outbox);
+
+    ASSERT_EQ(outbox.append(makeBatch({"first-msg", "second-msg"})), 2u);
+    ASSERT_TRUE(waitFor([&]() { return publisher.calls() > 0; }));
+    EXPECT_EQ(outbox.pending(), 2u);
+
+    publisher.allow(100);
+    EXPECT_EQ(outbox.drain(Clock::now() + std::chrono::seconds(10)), 0u);
+    EXPECT_EQ(publisher.published(), (std::vector<std::string>{"first-msg", "second-msg"}));
+    EXPECT_EQ(outbox.dropped(), 0u);
+}
+
+TEST_F(PublishOutboxTest, DropsBatchesAfterAPermanentError) {
+    FakePublisher publisher;
+    publisher.failPermanently();
+    PublishOutbox outbox(10, publisher.fn());
+    open(outbox);
+
+    ASSERT_EQ(outbox.append(makeBatch({"rejected-1", "rejected-2"})), 2u);
+    EXPECT_EQ(outbox.drain(Clock::now() + std::chrono::seconds(10)), 0u);
+    EXPECT_EQ(outbox.dropped(), 2u);
+}
+
+TEST_F(PublishOutboxTest, ReplaysUnsentRecordsAfterRestart) {
+    spillThree();
+
+    FakePublisher publisher;
+    publisher.allow(100);
+    PublishOutbox outbox(10, publisher.fn());
+    open(outbox);
+    EXPECT_EQ(outbox.drain(Clock::now() + std::chrono::seconds(10)), 0u);
+    EXPECT_EQ(publisher.published(),
+              (std::vector<std::string>{"record-1", "record-2", "record-3"}));
+}
+
+TEST_F(PublishOutboxTest, DropsACorruptLastRecord) {
+    spillThree();
+    // Flip the final payload byte, as a write torn by a crash would leave it
+    uint64_t end = readWriteOffset();
+    char garbage = '\x7f';
+    patch(static_cast<off_t>(end - 1), &garbage, 1);
+
+    FakePublisher publisher;
+    publisher.allow(100);
+    PublishOutbox outbox(10, publisher.fn());
+    open(outbox);
+    EXPECT_EQ(outbox.drain(Clock::now() + std::chrono::seconds(10)), 0u);
+    EXPECT_EQ(publisher.published(), (std::vector<std::string>{"record-1", "record-2"}));
+}
+
+TEST_F(PublishOutboxTest, DropsATruncatedTail) {
+    spillThree();
+    // Advance the write offset over bytes no record was completed in
+    uint64_t end = readWriteOffset();
+    std::vector<unsigned char> partial(40, 0xAB);
+    patch(static_cast<off_t>(end), partial.data(), partial.size());
+    uint64_t torn = end + partial.size();
+    patch(WRITE_OFFSET_AT, &torn, sizeof(torn));
+
+    FakePublisher publisher;
+    PublishOutbox outbox(10, publisher.fn());
+    open(outbox);
+    EXPECT_EQ(outbox.pending(), 3u);
+    publisher.allow(100);
+    EXPECT_EQ(outbox.drain(Clock::now() + std::chrono::seconds(10)), 0u);
+    EXPECT_EQ(publisher.published(),
+              (std::vector<std::string>{"record-1", "record-2", "record-3"}));
+}
+
+TEST_F(PublishOutboxTest, ResetsAnUnrecognisedSegment) {
+    std::vector<unsigned char> junk(HEADER_SIZE, 0xFF);
+    int fd = ::open(path_.c_str(), O_WRONLY | O_CREAT, 0600);
+    ASSERT_EQ(write(fd, junk.data(), junk.size()), static_cast<ssize_t>(junk.size()));
+    close(fd);
+
+    FakePublisher publisher;
+    PublishOutbox outbox(10, publisher.fn());
+    open(outbox);
+    EXPECT_EQ(outbox.pending(), 0u);
+    EXPECT_EQ(outbox.append(makeBatch({"after-reset"})), 1u);
+}
+
+TEST_F(PublishOutboxTest, DropsWhatDoesNotFitAndCountsIt) {
+    FakePublisher publisher;
+    PublishOutbox outbox(10, publisher.fn());
+    open(outbox);
+
+    const std::string big(20000, 'x');
+    EXPECT_EQ(outbox.append(makeBatch({big, big, big, big, big})), 3u);
+    EXPECT_EQ(outbox.dropped(), 2u);
+    EXPECT_EQ(outbox.pending(), 3u);
+}
+
+TEST_F(PublishOutboxTest, CompactsAcknowledgedSpace) {
+    FakePublisher publisher;
+    PublishOutbox outbox(1, publisher.fn());
+    open(outbox);
+
+    // Seven ~9 KB records fill most of the 64 KB segment
+    std::vector<std::string> records;
+    for (char c = 'a'; c < 'h'; ++c) {
+        records.push_back(std::string(9000, c));
+    }
+    ASSERT_EQ(outbox.append(makeBatch(records)), records.size());
+    const std::string next(9000, 'h');
+    ASSERT_GT(readWriteOffset() + next.size(), MIN_CAPACITY);
+
+    // Acknowledge the first three, leaving the rest pending behind a gap
+    publisher.allow(3);
+    ASSERT_TRUE(waitFor([&]() { return outbox.pending() == 4; }));
+
+    // Fits only once the acknowledged front has been reclaimed
+    EXPECT_EQ(outbox.append(makeBatch({next})), 1u);
+    EXPECT_EQ(outbox.dropped(), 0u);
+    records.push_back(next);
+
+    publisher.allow(100);
+    EXPECT_EQ(outbox.drain(Clock::now() + std::chrono::seconds(10)), 0u);
+    EXPECT_EQ(publisher.published(), records);
+}
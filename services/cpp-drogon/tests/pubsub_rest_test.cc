@@ -0,0 +1,102 @@
+/**
+ * Tests for the Pub/Sub REST publish body writer.
+ */
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "codec.h"
+#include "pubsub_rest.h"
+
+namespace {
+
+using Attributes = std::vector<std::pair<std::string, std::string>>;
+
+PubSubMessage makeMessage(const std::string& data, const Attributes& attributes = {}) {
+    PubSubMessage message(data.size());
+    message.data.assign(data);
+    for (const auto& [key, value] : attributes) {
+        message.attributes.emplace_back(std::string_view(key), std::string_view(value));
+    }
+    return message;
+}
+
+Json::Value parseJson(const std::string& text) {
+    Json::Value value;
+    std::string errors;
+    Json::CharReaderBuilder builder;
+    builder["strictRoot"] = true;
+    builder["allowComments"] = false;
+    builder["failIfExtra"] = true;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    EXPECT_TRUE(reader->parse(text.data(), text.data() + text.size(), &value, &errors))
+        << errors << "\n"
+        << text;
+    return value;
+}
+
+}  // namespace
+
+TEST(PublishBodyTest, WritesTheTopicsPublishShape) {
+    std::vector<PubSubMessage> batch;
+    batch.push_back(makeMessage("hi", {{"interaction_id", "1"}, {"timestamp", "t"}}));
+    batch.push_back(makeMessage("foobar"));
+    EXPECT_EQ(buildPublishBody(batch),
+              R"({"messages":[{"data":"aGk=","attributes":{"interaction_id":"1","timestamp":"t"}},)"
+              R"({"data":"Zm9vYmFy"}]})");
+}
+
+TEST(PublishBodyTest, EmptyBatch) {
+    EXPECT_EQ(buildPublishBody({}), R"({"messages":[]})");
+}
+
+TEST(PublishBodyTest, RoundTripsPayloadsAndEscapedAttributes) {
+    std::string binary;
+    for (int i = 0; i < 256; ++i) {
+        binary += static_cast<char>(i);
+    }
+    const Attributes attributes = {
+        {"quote\"key", "back\\slash"},
+        {"control", std::string("a\n\t\x01\0z", 6)},
+        {"utf8", "caf\xC3\xA9 \xF0\x9F\x98\x80"},
+        {"empty", ""},
+    };
+
+    std::vector<PubSubMessage> batch;
+    batch.push_back(makeMessage(R"({"type":2,"id":"x"})", attributes));
+    batch.push_back(makeMessage(binary, attributes));
+    batch.push_back(makeMessage(""));
+
+    Json::Value body = parseJson(buildPublishBody(batch));
+    ASSERT_EQ(body["messages"].size(), batch.size());
+    for (Json::ArrayIndex i = 0; i < batch.size(); ++i) {
+        const Json::Value& message = body["messages"][i];
+        std::string data(batch[i].data.data(), batch[i].data.size());
+        EXPECT_EQ(message["data"].asString(), base64Encode(data)) << i;
+        EXPECT_EQ(message.isMember("attributes"), !batch[i].attributes.empty()) << i;
+        for (const auto& [key, value] : batch[i].attributes) {
+            EXPECT_EQ(message["attributes"][std::string(key)].asString(), std::string(value))
+                << i << " " << key;
+        }
+    }
+}
+
+TEST(PublishBodyTest, MatchesJsonCppForManyMessages) {
+    std::vector<PubSubMessage> batch;
+    Json::Value expected;
+    expected["messages"] = Json::Value(Json::arrayValue);
+    for (int i = 0; i < 100; ++i) {
+        std::string data(static_cast<size_t>(i * 7), static_cast<char>('a' + i % 26));
+        std::string id = std::to_string(i);
+        batch.push_back(makeMessage(data, {{"interaction_id", id}}));
+        Json::Value message;
+        message["data"] = base64Encode(data);
+        message["attributes"]["interaction_id"] = id;
+        expected["messages"].append(message);
+    }
+    EXPECT_EQ(parseJson(buildPublishBody(batch)), expected);
+}
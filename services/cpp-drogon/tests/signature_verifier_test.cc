@@ -0,0 +1,149 @@
+/**
+ * Tests for request signature verification and the per-thread verdict cache.
+ */
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <sodium.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench/fixtures.h"
+#include "signature_verifier.h"
+#include "wall_clock.h"
+
+namespace {
+
+class SignatureVerifierTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        ASSERT_GE(sodium_init(), 0);
+        signer_ = std::make_unique<TestSigner>();
+        std::string error;
+        ASSERT_TRUE(verifier_.setPublicKey(std::string(TEST_PUBLIC_KEY_HEX), error)) << error;
+    }
+
+    static std::string now() {
+        return std::to_string(wallClockSeconds());
+    }
+
+    std::unique_ptr<TestSigner> signer_;
+    SignatureVerifier verifier_;
+};
+
+/**
+ * Same signature with one hex digit changed
+ */
+std::string flipDigit(std::string hex, size_t pos) {
+    hex[pos] = hex[pos] == '0' ? '1' : '0';
+    return hex;
+}
+
+}  // namespace
+
+TEST_F(SignatureVerifierTest, AcceptsAFreshSignedRequest) {
+    std::string ts = now();
+    EXPECT_TRUE(verifier_.verifyRequest(signer_->sign(ts, SLASH_COMMAND_BODY), ts,
+                                        SLASH_COMMAND_BODY));
+    EXPECT_TRUE(verifier_.verifyRequest(signer_->sign(ts, PING_BODY), ts, PING_BODY));
+}
+
+TEST_F(SignatureVerifierTest, RejectsTamperedAndMalformedRequests) {
+    std::string ts = now();
+    std::string signature = signer_->sign(ts, PING_BODY);
+    std::string body(PING_BODY);
+    body.back() = ' ';
+    EXPECT_FALSE(verifier_.verifyRequest(signature, ts, body));
+    EXPECT_FALSE(verifier_.verifyRequest(flipDigit(signature, 10), ts, PING_BODY));
+    EXPECT_FALSE(verifier_.verifyRequest(signature.substr(2), ts, PING_BODY));
+    EXPECT_FALSE(verifier_.verifyRequest(signature + "00", ts, PING_BODY));
+    EXPECT_FALSE(verifier_.verifyRequest("zz" + signature.substr(2), ts, PING_BODY));
+    EXPECT_FALSE(verifier_.verifyRequest("", ts, PING_BODY));
+    EXPECT_FALSE(verifier_.verifyRequest(signature, "", PING_BODY));
+    EXPECT_FALSE(verifier_.verifyRequest(signature, " " + ts, PING_BODY));
+}
+
+TEST_F(SignatureVerifierTest, RejectsStaleTimestamps) {
+    std::string ts = std::to_string(wallClockSeconds() - SignatureVerifier::MAX_TIMESTAMP_AGE - 2);
+    EXPECT_FALSE(verifier_.verifyRequest(signer_->sign(ts, PING_BODY), ts, PING_BODY));
+}
+
+TEST_F(SignatureVerifierTest, CachedBodyWithAnotherSignatureIsRejected) {
+    std::string ts = now();
+    std::string signature = signer_->sign(ts, SLASH_COMMAND_BODY);
+    ASSERT_TRUE(verifier_.verifyRequest(signature, ts, SLASH_COMMAND_BODY));
+    ASSERT_TRUE(verifier_.verifyRequest(signature, ts, SLASH_COMMAND_BODY));
+
+    // The body and timestamp are cached as verified; the signature is not theirs
+    for (size_t pos = 0; pos < signature.size(); pos += 7) {
+        EXPECT_FALSE(verifier_.verifyRequest(flipDigit(signature, pos), ts, SLASH_COMMAND_BODY))
+            << "position " << pos;
+    }
+    EXPECT_FALSE(verifier_.verifyRequest(std::string(signature.size(), '0'), ts,
+                                         SLASH_COMMAND_BODY));
+    EXPECT_TRUE(verifier_.verifyRequest(signature, ts, SLASH_COMMAND_BODY));
+}
+
+TEST_F(SignatureVerifierTest, CachedSignatureWithAnotherTimestampIsRejected) {
+    std::string ts = now();
+    std::string signature = signer_->sign(ts, PING_BODY);
+    ASSERT_TRUE(verifier_.verifyRequest(signature, ts, PING_BODY));
+    EXPECT_FALSE(verifier_.verifyRequest(signature, std::to_string(std::stoll(ts) - 1), PING_BODY));
+    EXPECT_FALSE(verifier_.verifyRequest(signature, "0" + ts, PING_BODY));
+}
+
+TEST_F(SignatureVerifierTest, CachedRequestStillExpires) {
+    int64_t oldest = wallClockSeconds() - SignatureVerifier::MAX_TIMESTAMP_AGE;
+    std::string ts = std::to_string(oldest);
+    std::string signature = signer_->sign(ts, PING_BODY);
+    ASSERT_TRUE(verifier_.verifyRequest(signature, ts, PING_BODY));
+    while (wallClockSeconds() - oldest <= SignatureVerifier::MAX_TIMESTAMP_AGE) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    EXPECT_FALSE(verifier_.verifyRequest(signature, ts, PING_BODY));
+}
+
+TEST_F(SignatureVerifierTest, CacheNeverChangesAVerdict) {
+    SignatureVerifier uncached;
+    std::string error;
+    ASSERT_TRUE(uncached.setPublicKey(std::string(TEST_PUBLIC_KEY_HEX), error));
+    uncached.setVerdictCache(false);
+
+    // Enough distinct requests to reuse every slot of the direct-mapped cache
+    std::mt19937 rng(3);
+    std::string ts = now();
+    std::vector<std::string> bodies;
+    for (int i = 0; i < 200; ++i) {
+        bodies.push_back(R"({"type":2,"id":")" + std::to_string(i) + "\"}");
+    }
+    for (int round = 0; round < 2000; ++round) {
+        const std::string& body = bodies[rng() % bodies.size()];
+        std::string signature = signer_->sign(ts, body);
+        if (rng() % 3 == 0) {
+            signature = flipDigit(signature, rng() % signature.size());
+        }
+        ASSERT_EQ(verifier_.verifyRequest(signature, ts, body),
+                  uncached.verifyRequest(signature, ts, body))
+            << body;
+    }
+}
+
+TEST(SignatureVerifierKeyTest, RejectsBadPublicKeys) {
+    ASSERT_GE(sodium_init(), 0);
+    SignatureVerifier verifier;
+    std::string error;
+    EXPECT_FALSE(verifier.setPublicKey("abcd", error));
+    EXPECT_EQ(error, "length");
+    EXPECT_FALSE(verifier.setPublicKey(std::string(64, 'g'), error));
+    EXPECT_EQ(error, "format");
+    // The identity point has small order
+    EXPECT_FALSE(verifier.setPublicKey("01" + std::string(62, '0'), error));
+    EXPECT_EQ(error, "point");
+    EXPECT_FALSE(verifier.ready());
+
+    unsigned char signature[crypto_sign_BYTES] = {};
+    EXPECT_FALSE(verifier.verify(signature, "1", "{}"));
+}
@@ -0,0 +1,99 @@
+/**
+ * Tests for PUBSUB_ROUTES parsing and command lookup.
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "topic_router.h"
+
+namespace {
+
+const std::string DEFAULT_TOPIC = "projects/p/topics/interactions";
+
+}  // namespace
+
+TEST(TopicRouterTest, EmptySpecRoutesEverythingToTheDefault) {
+    TopicRouter router;
+    std::string error;
+    ASSERT_TRUE(router.configure(DEFAULT_TOPIC, "", error)) << error;
+    EXPECT_EQ(router.topics(), (std::vector<std::string>{DEFAULT_TOPIC}));
+    EXPECT_EQ(router.route("ping"), 0u);
+    EXPECT_EQ(router.route(""), 0u);
+}
+
+TEST(TopicRouterTest, RoutesListedCommands) {
+    TopicRouter router;
+    std::string error;
+    ASSERT_TRUE(router.configure(DEFAULT_TOPIC, "ping=fast,report=bulk,export=bulk", error))
+        << error;
+    EXPECT_EQ(router.topics(), (std::vector<std::string>{DEFAULT_TOPIC, "fast", "bulk"}));
+    EXPECT_EQ(router.route("ping"), 1u);
+    EXPECT_EQ(router.route("report"), 2u);
+    EXPECT_EQ(router.route("export"), 2u);
+    EXPECT_EQ(router.route("other"), 0u);
+    EXPECT_EQ(router.route("Ping"), 0u);
+    EXPECT_EQ(router.route("pin"), 0u);
+    EXPECT_EQ(router.route("pingg"), 0u);
+}
+
+TEST(TopicRouterTest, ToleratesWhitespaceAndEmptyEntries) {
+    TopicRouter router;
+    std::string error;
+    ASSERT_TRUE(router.configure(DEFAULT_TOPIC, " ping = fast ,,\treport=bulk\t, ", error))
+        << error;
+    EXPECT_EQ(router.topics(), (std::vector<std::string>{DEFAULT_TOPIC, "fast", "bulk"}));
+    EXPECT_EQ(router.route("ping"), 1u);
+    EXPECT_EQ(router.route("report"), 2u);
+}
+
+TEST(TopicRouterTest, RoutedToTheDefaultTopicSharesItsPipeline) {
+    TopicRouter router;
+    std::string error;
+    ASSERT_TRUE(router.configure(DEFAULT_TOPIC, "ping=" + DEFAULT_TOPIC, error)) << error;
+    EXPECT_EQ(router.topics().size(), 1u);
+    EXPECT_EQ(router.route("ping"), 0u);
+}
+
+TEST(TopicRouterTest, RejectsMalformedEntries) {
+    for (const char* spec : {"ping", "ping=", "=fast", " = ", "ping=fast,report"}) {
+        TopicRouter router;
+        std::string error;
+        EXPECT_FALSE(router.configure(DEFAULT_TOPIC, spec, error)) << spec;
+        EXPECT_NE(error.find("expected command=topic"), std::string::npos) << error;
+    }
+}
+
+TEST(TopicRouterTest, RejectsDuplicateCommands) {
+    TopicRouter router;
+    std::string error;
+    EXPECT_FALSE(router.configure(DEFAULT_TOPIC, "ping=fast,report=bulk,ping=bulk", error));
+    EXPECT_EQ(error, "command \"ping\" routed twice");
+}
+
+TEST(TopicRouterTest, FindsEveryCommandInALargeTable) {
+    std::string spec;
+    for (int i = 0; i < 500; ++i) {
+        spec += "cmd" + std::to_string(i) + "=topic" + std::to_string(i % 7) + ",";
+    }
+    TopicRouter router;
+    std::string error;
+    ASSERT_TRUE(router.configure(DEFAULT_TOPIC, spec, error)) << error;
+    ASSERT_EQ(router.topics().size(), 8u);
+    for (int i = 0; i < 500; ++i) {
+        size_t topic = router.route("cmd" + std::to_string(i));
+        ASSERT_EQ(router.topics()[topic], "topic" + std::to_string(i % 7)) << i;
+    }
+    EXPECT_EQ(router.route("cmd500"), 0u);
+}
+
+TEST(TopicRouterTest, ReconfigureReplacesTheTable) {
+    TopicRouter router;
+    std::string error;
+    ASSERT_TRUE(router.configure(DEFAULT_TOPIC, "ping=fast", error));
+    ASSERT_TRUE(router.configure(DEFAULT_TOPIC, "report=bulk", error));
+    EXPECT_EQ(router.topics(), (std::vector<std::string>{DEFAULT_TOPIC, "bulk"}));
+    EXPECT_EQ(router.route("ping"), 0u);
+    EXPECT_EQ(router.route("report"), 1u);
+}
@@ -0,0 +1,93 @@
+/**
+ * Slash command to Pub/Sub topic routing.
+ */
+
+#include "topic_router.h"
+
+#include <algorithm>
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+uint64_t fnv1a(std::string_view text) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+}  // namespace
+
+bool TopicRouter::configure(const std::string& default_topic, std::string_view spec,
+                            std::string& error) {
+    topics_.assign(1, default_topic);
+    std::vector<std::pair<std::string_view, size_t>> routes;
+    for (size_t pos = 0; pos <= spec.size();) {
+        size_t comma = std::min(spec.find(',', pos), spec.size());
+        std::string_view entry = trim(spec.substr(pos, comma - pos));
+        pos = comma + 1;
+        if (entry.empty()) {
+            continue;
+        }
+        size_t eq = entry.find('=');
+        std::string_view command = trim(entry.substr(0, eq));
+        std::string_view topic = eq == std::string_view::npos ? "" : trim(entry.substr(eq + 1));
+        if (command.empty() || topic.empty()) {
+            error = "expected command=topic, got \"" + std::string(entry) + "\"";
+            return false;
+        }
+        auto known = std::find(topics_.begin(), topics_.end(), topic);
+        if (known == topics_.end()) {
+            known = topics_.emplace(topics_.end(), topic);
+        }
+        routes.emplace_back(command, known - topics_.begin());
+    }
+
+    // At most half full, so probes stay short and always reach a free slot
+    size_t capacity = 1;
+    while (capacity < routes.size() * 2) {
+        capacity <<= 1;
+    }
+    slots_.assign(capacity, Slot{});
+    mask_ = capacity - 1;
+    for (const auto& [command, topic] : routes) {
+        uint64_t hash = fnv1a(command);
+        size_t i = hash & mask_;
+        while (!slots_[i].command.empty()) {
+            if (slots_[i].command == command) {
+                error = "command \"" + std::string(command) + "\" routed twice";
+                return false;
+            }
+            i = (i + 1) & mask_;
+        }
+        slots_[i] = {hash, std::string(command), topic};
+    }
+    return true;
+}
+
+size_t TopicRouter::route(std::string_view command) const {
+    if (slots_.empty() || command.empty()) {
+        return 0;
+    }
+    uint64_t hash = fnv1a(command);
+    for (size_t i = hash & mask_;; i = (i + 1) & mask_) {
+        const Slot& slot = slots_[i];
+        if (slot.command.empty()) {
+            return 0;
+        }
+        if (slot.hash == hash && slot.command == command) {
+            return slot.topic;
+        }
+    }
+}
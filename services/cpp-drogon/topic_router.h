@@ -0,0 +1,50 @@
+/**
+ * Slash command to Pub/Sub topic routing.
+ *
+ * PUBSUB_ROUTES maps command names to topics ("ping=fast,report=bulk");
+ * commands not listed go to the default topic. Each distinct topic gets its
+ * own publish pipeline, so a heavy command cannot hold up the others. The
+ * table is built once at startup as an open-addressing hash over the names:
+ * a lookup is one FNV-1a pass and usually one comparison, with no allocation.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class TopicRouter {
+  public:
+    /**
+     * Build the table from a PUBSUB_ROUTES spec (comma-separated
+     * name=topic pairs, may be empty). Returns false with a message if a
+     * pair is malformed or a command is listed twice.
+     */
+    bool configure(const std::string& default_topic, std::string_view spec, std::string& error);
+
+    /**
+     * Index into topics() for a command name; 0 (the default topic) if not routed
+     */
+    size_t route(std::string_view command) const;
+
+    /**
+     * Distinct topics, the default first
+     */
+    const std::vector<std::string>& topics() const {
+        return topics_;
+    }
+
+  private:
+    struct Slot {
+        uint64_t hash = 0;
+        std::string command;  // Empty when the slot is free
+        size_t topic = 0;
+    };
+
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+    std::vector<std::string> topics_;
+};
@@ -0,0 +1,78 @@
+/**
+ * Cheap wall-clock reads and allocation-free timestamp handling.
+ */
+
+#include "wall_clock.h"
+
+#include <charconv>
+#include <time.h>
+
+namespace {
+
+void writeDigits(char* out, unsigned value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+}  // namespace
+
+int64_t wallClockSeconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return static_cast<int64_t>(ts.tv_sec);
+}
+
+void formatIso8601(int64_t seconds, char* out) {
+    int64_t days = seconds / 86400;
+    int64_t rem = seconds % 86400;
+    if (rem < 0) {
+        rem += 86400;
+        --days;
+    }
+
+    // Days since 1970-01-01 to a proleptic Gregorian date (Howard Hinnant's civil_from_days)
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned day = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+    const int64_t year = static_cast<int64_t>(yoe) + era * 400 + (month <= 2 ? 1 : 0);
+
+    writeDigits(out, static_cast<unsigned>(year), 4);
+    out[4] = '-';
+    writeDigits(out + 5, month, 2);
+    out[7] = '-';
+    writeDigits(out + 8, day, 2);
+    out[10] = 'T';
+    writeDigits(out + 11, static_cast<unsigned>(rem / 3600), 2);
+    out[13] = ':';
+    writeDigits(out + 14, static_cast<unsigned>(rem / 60 % 60), 2);
+    out[16] = ':';
+    writeDigits(out + 17, static_cast<unsigned>(rem % 60), 2);
+    out[19] = 'Z';
+}
+
+std::string_view currentIso8601() {
+    thread_local int64_t cached_second = -1;
+    thread_local char cached[ISO8601_LENGTH];
+
+    int64_t now = wallClockSeconds();
+    if (now != cached_second) {
+        formatIso8601(now, cached);
+        cached_second = now;
+    }
+    return std::string_view(cached, ISO8601_LENGTH);
+}
+
+bool parseEpochSeconds(std::string_view text, int64_t& out) {
+    if (text.empty() || text.front() < '0' || text.front() > '9') {
+        return false;
+    }
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    return ec == std::errc() && ptr == text.data() + text.size();
+}
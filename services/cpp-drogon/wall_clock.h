@@ -0,0 +1,40 @@
+/**
+ * Cheap wall-clock reads and allocation-free timestamp handling.
+ *
+ * The clock is CLOCK_REALTIME_COARSE, served from the vDSO without a
+ * syscall at tick resolution, which is plenty for second-granularity
+ * timestamps. ISO-8601 rendering uses civil-date arithmetic instead of
+ * gmtime/put_time, so there is no locale, no stream and no shared static
+ * struct tm to race on.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// "YYYY-MM-DDTHH:MM:SSZ"
+constexpr size_t ISO8601_LENGTH = 20;
+
+/**
+ * Seconds since the Unix epoch
+ */
+int64_t wallClockSeconds();
+
+/**
+ * Format epoch seconds as ISO-8601 UTC, writing exactly ISO8601_LENGTH characters
+ */
+void formatIso8601(int64_t seconds, char* out);
+
+/**
+ * Current time as ISO-8601 UTC. Cached per thread and re-rendered only when
+ * the second changes; the view stays valid until the next call on this thread.
+ */
+std::string_view currentIso8601();
+
+/**
+ * Parse unsigned decimal epoch seconds. Rejects signs, whitespace, trailing
+ * characters and values out of range.
+ */
+bool parseEpochSeconds(std::string_view text, int64_t& out);
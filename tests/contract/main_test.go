@@ -12,6 +12,8 @@ import (
 	"io"
 	"net/http"
 	"os"
+	"os/exec"
+	"sync"
 	"testing"
 	"time"
 
@@ -29,6 +31,16 @@ var (
 
 	// projectID is the GCP project ID for Pub/Sub
 	projectID string
+
+	// serviceTopic is the topic the service under test publishes to; tests that
+	// inspect published messages are skipped when it is not set
+	serviceTopic string
+
+	// logCommand prints the service's logs (e.g. "docker logs service-under-test")
+	logCommand string
+
+	// expectDedup marks services that publish a redelivered interaction only once
+	expectDedup bool
 )
 
 func TestMain(m *testing.M) {
@@ -44,6 +56,10 @@ func TestMain(m *testing.M) {
 		projectID = "test-project"
 	}
 
+	serviceTopic = os.Getenv("CONTRACT_TEST_PUBSUB_TOPIC")
+	logCommand = os.Getenv("CONTRACT_TEST_LOG_COMMAND")
+	expectDedup = os.Getenv("CONTRACT_TEST_EXPECT_DEDUP") == "1"
+
 	// Initialize Pub/Sub client if emulator is available
 	if emulatorHost := os.Getenv("PUBSUB_EMULATOR_HOST"); emulatorHost != "" {
 		ctx := context.Background()
@@ -246,3 +262,78 @@ func receiveMessage(t *testing.T, sub *pubsub.Subscription, timeout time.Duratio
 
 	return received, received != nil
 }
+
+// subscribeToServiceTopic subscribes to the topic the service publishes to,
+// creating the topic if the service has not used it yet
+func subscribeToServiceTopic(t *testing.T) (*pubsub.Subscription, func()) {
+	t.Helper()
+
+	if pubsubClient == nil {
+		t.Skip("Pub/Sub emulator not available")
+	}
+	if serviceTopic == "" {
+		t.Skip("CONTRACT_TEST_PUBSUB_TOPIC not set")
+	}
+
+	ctx := context.Background()
+	topic := pubsubClient.Topic(serviceTopic)
+	exists, err := topic.Exists(ctx)
+	if err != nil {
+		t.Fatalf("Failed to check topic: %v", err)
+	}
+	if !exists {
+		if topic, err = pubsubClient.CreateTopic(ctx, serviceTopic); err != nil {
+			t.Fatalf("Failed to create topic: %v", err)
+		}
+	}
+
+	sub, cleanupSub := createTestSubscription(t, topic)
+	return sub, func() {
+		cleanupSub()
+		topic.Stop()
+	}
+}
+
+// receiveMessagesFor collects the messages carrying an interaction_id
+// attribute of id that arrive within window
+func receiveMessagesFor(t *testing.T, sub *pubsub.Subscription, id string, window time.Duration) []*pubsub.Message {
+	t.Helper()
+
+	ctx, cancel := context.WithTimeout(context.Background(), window)
+	defer cancel()
+
+	var mu sync.Mutex
+	var received []*pubsub.Message
+	err := sub.Receive(ctx, func(ctx context.Context, msg *pubsub.Message) {
+		msg.Ack()
+		if msg.Attributes["interaction_id"] != id {
+			return
+		}
+		mu.Lock()
+		received = append(received, msg)
+		mu.Unlock()
+	})
+
+	if err != nil && err != context.Canceled {
+		t.Logf("Receive error: %v", err)
+	}
+
+	mu.Lock()
+	defer mu.Unlock()
+	return received
+}
+
+// serviceLogs returns everything the service under test has logged so far
+func serviceLogs(t *testing.T) string {
+	t.Helper()
+
+	if logCommand == "" {
+		t.Skip("CONTRACT_TEST_LOG_COMMAND not set")
+	}
+
+	output, err := exec.Command("sh", "-c", logCommand).CombinedOutput()
+	if err != nil {
+		t.Fatalf("Failed to read service logs: %v", err)
+	}
+	return string(output)
+}
@@ -0,0 +1,150 @@
+package contract
+
+import (
+	"encoding/json"
+	"fmt"
+	"net/http"
+	"reflect"
+	"strings"
+	"testing"
+	"time"
+
+	"github.com/pmgledhill102/discord-bot-test-suite/tests/contract/testkeys"
+)
+
+// rawSlashCommand is a slash command body written out by hand, so it carries
+// things a struct round-trip would lose: unknown fields, escapes, non-ASCII
+// text, nested options and a token
+func rawSlashCommand(id, token string) []byte {
+	return []byte(fmt.Sprintf(`{
+		"app_permissions": "442368",
+		"application_id": "app-1",
+		"channel_id": "channel-1",
+		"data": {"id": "cmd-1", "name": "report", "type": 1,
+			"options": [{"name": "text", "type": 3, "value": "café \"quoted\" \\ ok"}]},
+		"guild_id": "guild-1",
+		"guild_locale": "de",
+		"id": %q,
+		"locale": "en-US",
+		"member": {"user": {"id": "user-1", "username": "tester"}, "roles": ["r1", "r2"], "nick": null},
+		"token": %q,
+		"type": 2,
+		"version": 1
+	}`, id, token))
+}
+
+func TestPublish_SanitizedPayload(t *testing.T) {
+	sub, cleanup := subscribeToServiceTopic(t)
+	defer cleanup()
+
+	id := fmt.Sprintf("sanitize-%d", time.Now().UnixNano())
+	body := rawSlashCommand(id, "SANITIZE_SECRET_TOKEN")
+
+	resp, _ := sendRequest(t, body)
+	if resp.StatusCode != http.StatusOK {
+		t.Fatalf("Slash command failed with status %d", resp.StatusCode)
+	}
+
+	messages := receiveMessagesFor(t, sub, id, 5*time.Second)
+	if len(messages) != 1 {
+		t.Fatalf("Expected 1 Pub/Sub message for %s, got %d", id, len(messages))
+	}
+	msg := messages[0]
+
+	// Exactly the allowlisted fields of the request, values unchanged
+	var want map[string]interface{}
+	if err := json.Unmarshal(body, &want); err != nil {
+		t.Fatalf("Failed to parse request: %v", err)
+	}
+	for _, field := range []string{"token", "app_permissions", "version"} {
+		delete(want, field)
+	}
+	var got map[string]interface{}
+	if err := json.Unmarshal(msg.Data, &got); err != nil {
+		t.Fatalf("Pub/Sub message is not valid JSON: %v\nData: %s", err, string(msg.Data))
+	}
+	if !reflect.DeepEqual(got, want) {
+		t.Errorf("Sanitized payload mismatch\nGot:  %s\nWant: %v", string(msg.Data), want)
+	}
+
+	wantAttributes := map[string]string{
+		"interaction_id":   id,
+		"interaction_type": "2",
+		"application_id":   "app-1",
+		"guild_id":         "guild-1",
+		"channel_id":       "channel-1",
+		"command_name":     "report",
+	}
+	for key, value := range wantAttributes {
+		if msg.Attributes[key] != value {
+			t.Errorf("Attribute %s = %q, want %q", key, msg.Attributes[key], value)
+		}
+	}
+	if _, err := time.Parse(time.RFC3339, msg.Attributes["timestamp"]); err != nil {
+		t.Errorf("Attribute timestamp %q is not ISO 8601: %v", msg.Attributes["timestamp"], err)
+	}
+}
+
+func TestPublish_DuplicateInteractionPublishedOnce(t *testing.T) {
+	if !expectDedup {
+		t.Skip("CONTRACT_TEST_EXPECT_DEDUP not set")
+	}
+	sub, cleanup := subscribeToServiceTopic(t)
+	defer cleanup()
+
+	// Discord redelivers the same interaction when it thinks the response timed out
+	id := fmt.Sprintf("dedup-%d", time.Now().UnixNano())
+	body := rawSlashCommand(id, "DEDUP_SECRET_TOKEN")
+	for attempt := 1; attempt <= 2; attempt++ {
+		resp, respBody := sendRequest(t, body)
+		if resp.StatusCode != http.StatusOK {
+			t.Fatalf("Delivery %d failed with status %d", attempt, resp.StatusCode)
+		}
+		if response := parseResponse(t, respBody); response.Type != 5 {
+			t.Errorf("Delivery %d: expected response type 5 (Deferred), got %d", attempt, response.Type)
+		}
+	}
+
+	messages := receiveMessagesFor(t, sub, id, 5*time.Second)
+	if len(messages) != 1 {
+		t.Errorf("Expected the interaction to be published once, got %d messages", len(messages))
+	}
+}
+
+func TestLogs_SecretsNeverLogged(t *testing.T) {
+	if logCommand == "" {
+		t.Skip("CONTRACT_TEST_LOG_COMMAND not set")
+	}
+
+	stamp := time.Now().UnixNano()
+	token := fmt.Sprintf("LOG_SECRET_TOKEN_%d", stamp)
+	marker := fmt.Sprintf("log-body-marker-%d", stamp)
+
+	// Accepted, malformed, unknown type and badly signed requests all carry
+	// the token, and the marker in a field nothing has a reason to log
+	slash := []byte(strings.Replace(string(rawSlashCommand(fmt.Sprintf("logs-%d", stamp), token)),
+		`"nick": null`, fmt.Sprintf(`"nick": %q`, marker), 1))
+	malformed := []byte(fmt.Sprintf(`{"type": 2, "nick": %q, "token": %q,`, marker, token))
+	unknown := []byte(fmt.Sprintf(`{"type": 99, "nick": %q, "token": %q}`, marker, token))
+
+	signature, timestamp := testkeys.SignRequest(slash)
+	sendRequestWithHeaders(t, slash, signature, timestamp)
+	sendRequest(t, malformed)
+	sendRequest(t, unknown)
+	sendRequestWithHeaders(t, slash, testkeys.InvalidSignature(), fmt.Sprintf("%d", time.Now().Unix()))
+
+	// Logs are written from a background thread
+	time.Sleep(time.Second)
+	logs := serviceLogs(t)
+
+	checks := map[string]string{
+		"interaction token":   token,
+		"request body":        marker,
+		"X-Signature-Ed25519": signature,
+	}
+	for what, secret := range checks {
+		if strings.Contains(logs, secret) {
+			t.Errorf("Service logs contain the %s", what)
+		}
+	}
+}